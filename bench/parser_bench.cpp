@@ -0,0 +1,561 @@
+#include <curses.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "batch.h"
+#include "canvas.h"
+#include "exporter.h"
+#include "linux_parser.h"
+#include "ncurses_display.h"
+#include "proc_fixture.h"
+#include "recording.h"
+#include "replay_system.h"
+#include "sample.h"
+#include "string_arena.h"
+#include "system.h"
+#if MONITOR_COLLECT_DEVICES
+#include "device_table.h"
+#endif
+
+/*
+Times the LinuxParser hot paths against synthetic /proc trees.
+
+Usage: monitor_bench [--sizes 1000,10000,100000] [--repeat 5]
+                     [--users 200] [--threads <max workers>]
+                     [--dir <fixture root>]
+
+Fixtures are kept below --dir and reused on the next run, so only the first
+run for a given size pays for generating them. Before timing, a few cheap
+checks compare what the parsers and writers produce with what the fixture
+wrote; a failed one is printed and makes the exit status 1.
+*/
+
+namespace {
+struct Config {
+  std::vector<int> sizes{1000, 10000, 100000};
+  int repeat{5};
+  int users{200};
+  std::size_t threads{std::max(1u, std::thread::hardware_concurrency())};
+  std::string dir{
+      (std::filesystem::temp_directory_path() / "monitor-bench").string()};
+};
+
+struct Result {
+  double ns{0};
+  long syscalls{0};
+};
+
+// Number of read syscalls this process issued so far. Always taken from the
+// real /proc, never from the fixture.
+long ReadSyscalls() {
+  std::ifstream stream("/proc/self/io");
+  std::string key;
+  long value{0};
+  while (stream >> key >> value) {
+    if (key == "syscr:") {
+      return value;
+    }
+  }
+  return 0;
+}
+
+// Median wall time of repeat runs of fn, plus the read syscalls of one run
+Result Measure(int repeat, const std::function<void()>& fn) {
+  std::vector<double> samples;
+  Result result;
+  for (int i = 0; i < repeat; ++i) {
+    long reads = ReadSyscalls();
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    auto stop = std::chrono::steady_clock::now();
+    result.syscalls = ReadSyscalls() - reads;
+    samples.emplace_back(
+        std::chrono::duration<double, std::nano>(stop - start).count());
+  }
+  std::sort(samples.begin(), samples.end());
+  result.ns = samples[samples.size() / 2];
+  return result;
+}
+
+// Print result, per item of the given unit
+void Report(const std::string& name, Result result, std::size_t items,
+            const char* unit = "pid") {
+  std::printf("  %-26s %12.3f ms %12.1f ns/%-6s %8.1f reads/%s\n",
+              name.c_str(), result.ns / 1e6, items ? result.ns / items : 0.0,
+              unit, items ? double(result.syscalls) / items : 0.0, unit);
+}
+
+// Keeps the optimizer from dropping the parser calls
+volatile long sink;
+
+// Checks failed so far, over all sizes
+int failures{0};
+
+void Expect(bool ok, const std::string& what) {
+  if (!ok) {
+    std::fprintf(stderr, "  check failed: %s\n", what.c_str());
+    ++failures;
+  }
+}
+
+// Check the paths the rows time against what the fixture wrote, so a faster
+// parser that reads the wrong field does not pass for an improvement
+void Check(const std::string& root) {
+  const ProcFixture::Probe& probe = ProcFixture::ProbeProcess();
+  LinuxParser::ProcessSnapshot snapshot;
+  const LinuxParser::ProcStat& stat = snapshot.stat;
+  Expect(LinuxParser::ReadProcess(probe.pid, snapshot) &&
+             stat.pid == probe.pid && stat.state == probe.state &&
+             stat.ppid == probe.ppid && stat.utime == probe.utime &&
+             stat.stime == probe.stime &&
+             stat.numThreads == probe.numThreads &&
+             stat.starttime == probe.starttime && stat.rss == probe.rss,
+         "stat fields after the comm \"" + probe.comm + "\"");
+  Expect(snapshot.ramKb == probe.rss * (sysconf(_SC_PAGESIZE) / 1024),
+         "resident set from stat");
+  Expect(snapshot.uid == probe.uid, "uid from status");
+  Expect(snapshot.command == probe.command, "cmdline with its NULs");
+
+#if MONITOR_COLLECT_DEVICES
+  DeviceTable devices;
+  devices.Refresh();
+  std::vector<std::string> disks;
+  for (const DeviceTable::Disk& disk : devices.Disks()) {
+    disks.emplace_back(disk.name);
+  }
+  Expect(disks == ProcFixture::WholeDisks(), "whole disks of diskstats");
+#endif
+
+  // Released ids leave tombstones in the lookup that later ones probe past,
+  // and releasing three quarters of the buffer compacts it
+  StringArena arena;
+  auto text = [](int i) { return "string " + std::string(40, 'x') +
+                                 std::to_string(i); };
+  std::vector<StringArena::Id> ids;
+  for (int i = 0; i < 4096; ++i) {
+    ids.emplace_back(arena.Intern(text(i)));
+  }
+  for (int i = 0; i < 4096; ++i) {
+    if (i % 4 != 0) {
+      arena.Release(ids[i]);
+    }
+  }
+  bool interned = true;
+  for (int i = 0; i < 4096; ++i) {
+    if (i % 4 == 0) {
+      interned = interned && arena.View(ids[i]) == text(i) &&
+                 arena.Intern(text(i)) == ids[i];
+    } else {
+      ids[i] = arena.Intern(text(i));
+    }
+  }
+  for (int i = 0; i < 4096; ++i) {
+    interned = interned && arena.View(ids[i]) == text(i);
+  }
+  Expect(interned, "StringArena after releases and compaction");
+
+  // A process with what the writers escape: quotes, backslashes, the NULs
+  // between arguments, a newline and a byte that is not UTF-8
+  Sample sample;
+  sample.tick = 7;
+  sample.timestamp = 1700000000123;
+  sample.cpu = 0.25f;
+  sample.memory = 0.5f;
+  sample.uptime = 864321;
+  sample.cores = {0.5f, 0.125f};
+  sample.processes.emplace_back(probe.pid, "a\"b\\c",
+                                probe.command + "\n\xff", 0.75f, 2048, 3600,
+                                512.0f, 1024.0f);
+
+  const std::string history = root + "/check-history";
+  std::filesystem::remove(history);
+  Recording::Writer writer;
+  Recording::Reader reader;
+  std::string error;
+  Sample copy;
+  bool recorded = writer.Open(history, 4, 2, 4, error);
+  if (recorded) {
+    writer.Append(sample);
+    recorded = reader.Open(history, error) && reader.Records() == 1 &&
+               reader.Read(0, copy);
+  }
+  Expect(recorded, "recording read back " + error);
+  if (recorded) {
+    const Process& process = sample.processes[0];
+    const Process& read = copy.processes[0];
+    Expect(copy.tick == sample.tick && copy.timestamp == sample.timestamp &&
+               copy.cpu == sample.cpu && copy.memory == sample.memory &&
+               copy.uptime == sample.uptime && copy.cores == sample.cores &&
+               copy.processes.size() == 1 && read.Pid() == process.Pid() &&
+               read.User() == process.User() &&
+               read.Command() == process.Command() &&
+               read.CpuUtilization() == process.CpuUtilization() &&
+               read.RamMb() == process.RamMb() &&
+               read.UpTime() == process.UpTime() &&
+               read.ReadRate() == process.ReadRate() &&
+               read.WriteRate() == process.WriteRate(),
+           "recording round trip");
+  }
+
+  std::string body;
+  Exporter::Render(sample, Collectors::kAll, body);
+  Expect(body.find("{pid=\"" + std::to_string(probe.pid) +
+                   "\",user=\"a\\\"b\\\\c\",command=\"/opt/probe --name "
+                   "a b\\n\xef\xbf\xbd\"} ") != std::string::npos,
+         "OpenMetrics label escaping");
+  Expect(body.size() >= 6 && body.compare(body.size() - 6, 6, "# EOF\n") == 0,
+         "OpenMetrics ends with # EOF");
+  // A command with an escape sequence reaches the terminal as plain cells
+  FILE* terminal = std::fopen("/dev/null", "w");
+  SCREEN* screen = newterm("xterm", terminal, stdin);
+  {
+    WINDOW* window = newwin(1, 20, 0, 0);
+    Canvas canvas(window);
+    canvas.Put(0, 0, std::string_view("a\x1b[2J\x7f\n", 7));
+    canvas.Flush();
+    std::string shown;
+    for (int column = 0; column < 7; ++column) {
+      shown += static_cast<char>(mvwinch(window, 0, column) & A_CHARTEXT);
+    }
+    Expect(shown == "a?[2J??", "control bytes drawn as '?'");
+  }
+  endwin();
+  delscreen(screen);
+  std::fclose(terminal);
+}
+
+void Run(const Config& config, int size) {
+  ProcFixture::Options options;
+  options.pids = size;
+  options.users = config.users;
+  const std::string root =
+      (std::filesystem::path(config.dir) / std::to_string(size)).string();
+  ProcFixture::Generate(root, options);
+  LinuxParser::SetProcDirectory(ProcFixture::ProcDirectory(root));
+  LinuxParser::SetPasswordPath(ProcFixture::PasswordPath(root));
+
+  const std::vector<int> pids = LinuxParser::Pids();
+  std::printf("%zu pids (%s)\n", pids.size(), root.c_str());
+  Check(root);
+
+  Report("Pids()", Measure(config.repeat, [] {
+           sink = LinuxParser::Pids().size();
+         }),
+         pids.size());
+  Report("ActiveJiffies(pid)", Measure(config.repeat, [&] {
+           for (int pid : pids) sink = LinuxParser::ActiveJiffies(pid);
+         }),
+         pids.size());
+  Report("Ram(pid)", Measure(config.repeat, [&] {
+           for (int pid : pids) sink = LinuxParser::Ram(pid).size();
+         }),
+         pids.size());
+  Report("User(pid)", Measure(config.repeat, [&] {
+           for (int pid : pids) sink = LinuxParser::User(pid).size();
+         }),
+         pids.size());
+
+  // The pre-snapshot way of building a Process: one parser call per field.
+  Report("per-field reads", Measure(config.repeat, [&] {
+           for (int pid : pids) {
+             sink = LinuxParser::Command(pid).size() +
+                    LinuxParser::Ram(pid).size() + LinuxParser::UpTime() +
+                    LinuxParser::UpTime(pid) + LinuxParser::User(pid).size() +
+                    LinuxParser::ActiveJiffies(pid);
+           }
+         }),
+         pids.size());
+  Report("ReadProcess(pid)", Measure(config.repeat, [&] {
+           LinuxParser::ProcessSnapshot snapshot;
+           for (int pid : pids) {
+             sink = LinuxParser::ReadProcess(pid, snapshot);
+           }
+         }),
+         pids.size());
+
+  Report("ReadIo(pid)", Measure(config.repeat, [&] {
+           LinuxParser::IoCounters io;
+           for (int pid : pids) {
+             sink = LinuxParser::ReadIo(pid, io);
+           }
+         }),
+         pids.size());
+
+#if MONITOR_COLLECT_DEVICES
+  DeviceTable devices;
+  devices.Refresh();
+  Report("DeviceTable::Refresh()",
+         Measure(config.repeat, [&] { devices.Refresh(); }),
+         devices.Disks().size() + devices.Interfaces().size(), "device");
+#endif
+
+  System stat;
+  Report("System::Refresh()", Measure(config.repeat, [&] {
+           stat.Refresh();
+           sink = stat.TotalProcesses();
+         }),
+         pids.size());
+
+  // The rows of collectors left out of the build would time empty calls
+#if MONITOR_COLLECT_PROCESSES
+  // Scaling of the parallel refresh, doubling the workers up to --threads
+  for (std::size_t threads = 1;; threads *= 2) {
+    threads = std::min(threads, config.threads);
+    System system(threads);
+    Report("System::Processes() x" + std::to_string(threads),
+           Measure(config.repeat, [&] { sink = system.Processes().Size(); }),
+           pids.size());
+    if (threads == config.threads) {
+      break;
+    }
+  }
+
+  // Tiered reads. The processes of the fixture never run, so after the
+  // warm-up each one is read once every few ticks. The budget row caps
+  // every tick at a tenth of a full refresh.
+  {
+    constexpr int kWarmUp{32};
+    System tiered(config.threads);
+    tiered.ScheduleReads(true, {});
+    for (int tick = 0; tick < kWarmUp; ++tick) {
+      tiered.Processes();
+    }
+    Report("Processes() tiered",
+           Measure(kWarmUp, [&] { sink = tiered.Processes().Size(); }),
+           pids.size());
+    System budget(config.threads);
+    budget.ScheduleReads(false, {pids.size() / 5, {}});
+    budget.Processes();
+    Report("Processes() budget 10%",
+           Measure(config.repeat, [&] { sink = budget.Processes().Size(); }),
+           pids.size());
+  }
+#endif
+
+  // Per cgroup aggregation, the first refresh maps every pid, the later
+  // ones only read the cgroup counters
+  LinuxParser::SetCgroupDirectory(ProcFixture::CgroupDirectory(root));
+#if MONITOR_COLLECT_CGROUPS
+  {
+    System cgroups(config.threads);
+    Report("RefreshCgroups() first", Measure(config.repeat, [&] {
+             cgroups.ShowCgroups(false);
+             cgroups.ShowCgroups(true);
+             cgroups.RefreshCgroups();
+           }),
+           pids.size());
+    Report("RefreshCgroups()", Measure(config.repeat, [&] {
+             cgroups.RefreshCgroups();
+           }),
+           pids.size());
+  }
+#endif
+
+  // Ordering cost on an already refreshed table
+  System system(config.threads);
+  system.Processes();
+  Report("TopProcesses(30)", Measure(config.repeat, [&] {
+           sink = system.TopProcesses(30).size();
+         }),
+         pids.size());
+  Report("SortedProcesses()", Measure(config.repeat, [&] {
+           sink = system.SortedProcesses().size();
+         }),
+         pids.size());
+
+  // Batch serialisation of every process, written to /dev/null
+  system.Refresh();
+  Sample sample;
+  system.Capture(sample, pids.size());
+  int null = open("/dev/null", O_WRONLY | O_CLOEXEC);
+  const std::pair<const char*, Batch::Format> formats[] = {
+      {"Batch json", Batch::Format::kJson},
+      {"Batch csv", Batch::Format::kCsv},
+      {"Batch binary", Batch::Format::kBinary}};
+  for (const auto& [name, format] : formats) {
+    Batch::Writer writer(format, null);
+    Report(name, Measure(config.repeat, [&] { sink = writer.Write(sample); }),
+           pids.size());
+  }
+  close(null);
+
+  // OpenMetrics exposition of every process, then scrapes of the top 30
+  // over a Unix socket, each a request and its complete response
+  std::string body;
+  Report("OpenMetrics render", Measure(config.repeat, [&] {
+           body.clear();
+           Exporter::Render(sample, Collectors::kAll, body);
+           sink = body.size();
+         }),
+         pids.size());
+  {
+    Exporter::Server server;
+    Exporter::Address address;
+    address.path = root + "/metrics.sock";
+    std::string error;
+    system.Capture(sample, 30);
+    server.Publish(sample, Collectors::kAll);
+    int client = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    sockaddr_un remote{};
+    remote.sun_family = AF_UNIX;
+    address.path.copy(remote.sun_path, sizeof(remote.sun_path) - 1);
+    if (server.Listen(address, error) &&
+        connect(client, reinterpret_cast<sockaddr*>(&remote),
+                sizeof(remote)) == 0) {
+      constexpr int kScrapes = 1000;
+      const char request[] = "GET /metrics HTTP/1.1\r\n\r\n";
+      std::string response(1 << 20, '\0');
+      Report("Scrape (unix socket)", Measure(config.repeat, [&] {
+               for (int scrape = 0; scrape < kScrapes; ++scrape) {
+                 sink = write(client, request, sizeof(request) - 1);
+                 // The body ends the response
+                 std::size_t size = 0;
+                 while (size < 6 ||
+                        response.compare(size - 6, 6, "# EOF\n") != 0) {
+                   const ssize_t got = read(client, &response[size],
+                                            response.size() - size);
+                   if (got <= 0) {
+                     return;
+                   }
+                   size += got;
+                 }
+               }
+             }),
+             kScrapes, "scrape");
+    }
+    close(client);
+  }
+
+  // Appending the top 30 to a history file
+  system.Capture(sample, 30);
+  Recording::Writer recorder;
+  std::string error;
+  if (recorder.Open(root + "/history", 3600, sample.cores.size(), 30,
+                    error)) {
+    Report("Recording append (top 30)",
+           Measure(config.repeat, [&] { recorder.Append(sample); }), 1,
+           "append");
+  }
+
+  // Render path fed from a recording, isolated from /proc. The records are
+  // a second apart and the top processes shift by one row between them.
+  const std::string history = root + "/replay";
+  std::filesystem::remove(history);
+  Recording::Writer frames;
+  if (!frames.Open(history, 64, sample.cores.size(), 30, error)) {
+    return;
+  }
+  system.Capture(sample, 60);
+  const std::vector<Process> candidates = sample.processes;
+  // The frames slide 30 rows over the top 60, which a build without the
+  // process collector does not capture
+  if (candidates.size() < 60) {
+    return;
+  }
+  for (int frame = 0; frame < 64; ++frame) {
+    sample.timestamp += 1000;
+    ++sample.uptime;
+    sample.processes.assign(candidates.begin() + frame % 30,
+                            candidates.begin() + frame % 30 + 30);
+    frames.Append(sample);
+  }
+  ReplaySystem replay;
+  if (!replay.Open(history, error)) {
+    return;
+  }
+  FILE* terminal = std::fopen("/dev/null", "w");
+  SCREEN* screen = newterm("xterm", terminal, stdin);
+  resize_term(60, 160);
+  {
+    Canvas system_canvas(newwin(12, 159, 0, 0));
+    Canvas process_canvas(newwin(33, 159, 12, 0));
+    std::size_t cells = 0;
+    Sample shown;
+    auto render = [&] {
+      replay.Capture(shown, 30);
+      system_canvas.Clear();
+      system_canvas.Box();
+      NCursesDisplay::DisplaySystem(shown, replay.OperatingSystem(),
+                                    replay.Kernel(), system_canvas);
+      process_canvas.Clear();
+      process_canvas.Box();
+      NCursesDisplay::DisplayProcesses(shown, process_canvas, 30);
+      const std::size_t sent = system_canvas.Flush() + process_canvas.Flush();
+      if (sent > 0) {
+        doupdate();
+      }
+      cells += sent;
+    };
+    constexpr int kFrames = 64;
+    Report("Render frame (replay)", Measure(config.repeat, [&] {
+             for (int frame = 0; frame < kFrames; ++frame) {
+               replay.Seek(std::chrono::seconds(frame == 0 ? -64 : 1));
+               render();
+             }
+           }),
+           kFrames, "frame");
+    std::printf("  %-26s %12.1f cells/frame\n", "",
+                double(cells) / (kFrames * config.repeat));
+    Report("Render frame (unchanged)", Measure(config.repeat, [&] {
+             for (int frame = 0; frame < kFrames; ++frame) {
+               render();
+             }
+           }),
+           kFrames, "frame");
+  }
+  endwin();
+  delscreen(screen);
+  std::fclose(terminal);
+}
+
+std::vector<int> ParseSizes(const std::string& list) {
+  std::vector<int> sizes;
+  std::istringstream stream(list);
+  std::string item;
+  while (std::getline(stream, item, ',')) {
+    sizes.emplace_back(std::atoi(item.c_str()));
+  }
+  return sizes;
+}
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  Config config;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    const std::string flag{argv[i]};
+    if (flag == "--sizes") {
+      config.sizes = ParseSizes(argv[i + 1]);
+    } else if (flag == "--repeat") {
+      config.repeat = std::max(1, std::atoi(argv[i + 1]));
+    } else if (flag == "--users") {
+      config.users = std::max(1, std::atoi(argv[i + 1]));
+    } else if (flag == "--threads") {
+      config.threads = std::max(1, std::atoi(argv[i + 1]));
+    } else if (flag == "--dir") {
+      config.dir = argv[i + 1];
+    } else {
+      std::fprintf(stderr, "unknown option %s\n", flag.c_str());
+      return 1;
+    }
+  }
+
+  for (int size : config.sizes) {
+    Run(config, size);
+  }
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,328 @@
+#include "proc_fixture.h"
+
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+const std::string kMarkerFilename{".fixture"};
+// Bumped when the layout changes, so older fixtures are generated again
+constexpr int kLayout{4};
+
+// A mix of daemon, user and kernel thread names. Some contain spaces and
+// parentheses on purpose, the kernel allows both in comm.
+const std::vector<std::string> kCommands{
+    "systemd",  "sshd",        "bash",       "java",        "postgres",
+    "nginx",    "python3",     "containerd", "tmux: server", "Web Content",
+    "(sd-pam)", "kworker/0:1", "ksoftirqd/3", "rcu_sched",   "migration/1"};
+
+std::string Marker(const ProcFixture::Options& options) {
+  std::ostringstream marker;
+  marker << 'v' << kLayout << ' ' << options.pids << ' ' << options.users
+         << ' ' << options.cpus << ' ' << options.cgroups << ' '
+         << options.seed;
+  return marker.str();
+}
+
+bool IsKernelThread(const std::string& comm) {
+  return comm.find('/') != std::string::npos || comm == "rcu_sched";
+}
+
+void WriteSystemFiles(const std::filesystem::path& proc,
+                      const ProcFixture::Options& options, std::mt19937& rng) {
+  std::uniform_int_distribution<long> jiffies(100000, 90000000);
+
+  std::ofstream stat(proc / "stat");
+  auto cpuLine = [&](const std::string& name, long scale) {
+    stat << name;
+    for (int state = 0; state < 10; ++state) {
+      stat << ' ' << (state < 8 ? jiffies(rng) * scale : 0);
+    }
+    stat << '\n';
+  };
+  cpuLine("cpu ", options.cpus);
+  for (int cpu = 0; cpu < options.cpus; ++cpu) {
+    cpuLine("cpu" + std::to_string(cpu), 1);
+  }
+  stat << "intr 3289571635 0 9 0 0 0 0 0 0 1 0 0 0 156 0 0 0\n"
+       << "ctxt 7120948213\n"
+       << "btime 1700000000\n"
+       << "processes " << options.pids * 7 << '\n'
+       << "procs_running " << 1 + options.pids / 200 << '\n'
+       << "procs_blocked 0\n"
+       << "softirq 1033451282 0 210913217 93 13482374 0 0 2108 2108 0\n";
+
+  std::ofstream(proc / "uptime") << "864321.57 5403112.88\n";
+  std::ofstream(proc / "version")
+      << "Linux version 6.1.0-fixture (bench@fixture) (gcc 12.2.0) #1 SMP\n";
+  std::ofstream(proc / "meminfo") << "MemTotal:       263842316 kB\n"
+                                  << "MemFree:         81233104 kB\n"
+                                  << "MemAvailable:   190512844 kB\n"
+                                  << "Buffers:          2100412 kB\n"
+                                  << "Cached:         104123480 kB\n"
+                                  << "SwapCached:             0 kB\n"
+                                  << "Active:          98312116 kB\n"
+                                  << "Inactive:        71823112 kB\n"
+                                  << "SwapTotal:        8388604 kB\n"
+                                  << "SwapFree:         8388604 kB\n";
+
+  // Unused loop devices, two disks with partitions and a device mapper
+  // volume on top
+  std::uniform_int_distribution<unsigned long long> count(1000, 1ULL << 32);
+  std::ofstream diskstats(proc / "diskstats");
+  auto disk = [&](int major, int minor, const std::string& name, bool used) {
+    diskstats << std::setw(4) << major << std::setw(8) << minor << ' '
+              << name;
+    for (int field = 0; field < 17; ++field) {
+      diskstats << ' ' << (used && field != 8 ? count(rng) : 0);
+    }
+    diskstats << '\n';
+  };
+  for (int loop = 0; loop < 8; ++loop) {
+    disk(7, loop, "loop" + std::to_string(loop), false);
+  }
+  disk(7, 10, "loop10", true);
+  disk(259, 0, "nvme0n1", true);
+  for (int partition = 1; partition <= 3; ++partition) {
+    disk(259, partition, "nvme0n1p" + std::to_string(partition), true);
+  }
+  disk(8, 0, "sda", true);
+  disk(8, 1, "sda1", true);
+  disk(253, 0, "dm-0", true);
+
+  std::ofstream netdev(proc / "net" / "dev");
+  netdev << "Inter-|   Receive                            "
+         << "                    |  Transmit\n"
+         << " face |bytes    packets errs drop fifo frame compressed "
+         << "multicast|bytes    packets errs drop fifo colls carrier "
+         << "compressed\n";
+  for (const char* name : {"lo", "eth0", "eth1", "docker0", "veth1a2b3c"}) {
+    netdev << std::setw(7) << name << ':';
+    for (int field = 0; field < 16; ++field) {
+      netdev << ' ' << (field % 8 < 2 ? count(rng) : 0);
+    }
+    netdev << '\n';
+  }
+}
+
+// cpu.stat, memory.current (not in the root) and io.stat of one cgroup
+void WriteCgroup(const std::filesystem::path& dir, bool root,
+                 std::mt19937& rng) {
+  std::uniform_int_distribution<unsigned long long> usec(1000000,
+                                                         900000000000ULL);
+  std::uniform_int_distribution<unsigned long long> bytes(0, 1ULL << 40);
+  std::filesystem::create_directories(dir);
+  const unsigned long long usage = usec(rng);
+  std::ofstream(dir / "cpu.stat")
+      << "usage_usec " << usage << "\nuser_usec " << usage / 3 * 2
+      << "\nsystem_usec " << usage / 3 << "\nnr_periods 0\nnr_throttled 0\n"
+      << "throttled_usec 0\nnr_bursts 0\nburst_usec 0\n";
+  if (!root) {
+    std::ofstream(dir / "memory.current") << (bytes(rng) >> 8) << '\n';
+  }
+  std::ofstream io(dir / "io.stat");
+  for (const char* device : {"8:0", "8:16", "259:0"}) {
+    io << device << " rbytes=" << bytes(rng) << " wbytes=" << bytes(rng)
+       << " rios=" << bytes(rng) / 4096 << " wios=" << bytes(rng) / 4096
+       << " dbytes=0 dios=0\n";
+  }
+}
+
+void WriteCgroups(const std::filesystem::path& cgroup,
+                  const ProcFixture::Options& options, std::mt19937& rng) {
+  WriteCgroup(cgroup, true, rng);
+  for (int service = 0; service < options.cgroups; ++service) {
+    WriteCgroup(cgroup / "system.slice" /
+                    ("service" + std::to_string(service) + ".service"),
+                false, rng);
+  }
+}
+
+void WriteProcess(const std::filesystem::path& proc, int pid,
+                  const ProcFixture::Options& options, std::mt19937& rng) {
+  std::uniform_int_distribution<std::size_t> pick(0, kCommands.size() - 1);
+  std::uniform_int_distribution<int> uid(0, options.users - 1);
+  std::uniform_int_distribution<long> ticks(0, 5000000);
+  std::uniform_int_distribution<long> rssKb(512, 8 * 1024 * 1024);
+  std::uniform_int_distribution<int> threads(1, 64);
+  std::uniform_int_distribution<int> cpu(0, options.cpus - 1);
+
+  const std::string& comm = kCommands[pick(rng)];
+  const bool kernel = IsKernelThread(comm);
+  const int ppid = kernel ? 2 : 1;
+  const int user = kernel ? 0 : uid(rng);
+  const long rss = kernel ? 0 : rssKb(rng);
+  const int numThreads = kernel ? 1 : threads(rng);
+  const long starttime = ticks(rng) * 10;
+
+  const std::filesystem::path dir = proc / std::to_string(pid);
+  std::filesystem::create_directory(dir);
+
+  std::ofstream(dir / "stat")
+      << pid << " (" << comm << ") " << (pid % 17 == 0 ? 'R' : 'S') << ' '
+      << ppid << ' ' << pid << ' ' << pid << " 0 -1 4194560 " << ticks(rng)
+      << " 0 " << ticks(rng) / 1000 << " 0 " << ticks(rng) << ' ' << ticks(rng)
+      << ' ' << ticks(rng) / 100 << ' ' << ticks(rng) / 100 << " 20 0 "
+      << numThreads << " 0 " << starttime << ' ' << rss * 4096 << ' '
+      << rss / 4 << " 18446744073709551615 94352713879552 94352714512877 "
+      << "140727468512304 0 0 0 671173123 4096 1260 1 0 0 17 " << cpu(rng)
+      << " 0 0 0 0 0 94352714643888 94352714710128 94352734085120 "
+      << "140727468519245 140727468519268 140727468519268 140727468519399 0\n";
+
+  std::ofstream status(dir / "status");
+  status << "Name:\t" << comm << "\nUmask:\t0022\nState:\tS (sleeping)\n"
+         << "Tgid:\t" << pid << "\nNgid:\t0\nPid:\t" << pid
+         << "\nPPid:\t" << ppid << "\nTracerPid:\t0\n"
+         << "Uid:\t" << user << '\t' << user << '\t' << user << '\t' << user
+         << "\nGid:\t" << user << '\t' << user << '\t' << user << '\t' << user
+         << "\nFDSize:\t64\nGroups:\t" << user << " \n"
+         << "NStgid:\t" << pid << "\nNSpid:\t" << pid << "\nNSpgid:\t" << pid
+         << "\nNSsid:\t" << pid << '\n';
+  if (!kernel) {
+    status << "VmPeak:\t" << rss * 3 << " kB\nVmSize:\t" << rss * 2
+           << " kB\nVmLck:\t       0 kB\nVmPin:\t       0 kB\nVmHWM:\t"
+           << rss + 128 << " kB\nVmRSS:\t" << rss << " kB\n"
+           << "RssAnon:\t" << rss / 2 << " kB\nRssFile:\t" << rss / 2
+           << " kB\nRssShmem:\t       0 kB\nVmData:\t" << rss
+           << " kB\nVmStk:\t     132 kB\nVmExe:\t     940 kB\n"
+           << "VmLib:\t   10972 kB\nVmPTE:\t     212 kB\n"
+           << "VmSwap:\t       0 kB\n";
+  }
+  status << "Threads:\t" << numThreads
+         << "\nSigQ:\t0/1030425\nSigPnd:\t0000000000000000\n"
+         << "ShdPnd:\t0000000000000000\nSigBlk:\t0000000000000000\n"
+         << "SigIgn:\t0000000000001000\nSigCgt:\t0000000180004a02\n"
+         << "CapInh:\t0000000000000000\nCapPrm:\t0000000000000000\n"
+         << "CapEff:\t0000000000000000\nCapBnd:\t000001ffffffffff\n"
+         << "Seccomp:\t0\nCpus_allowed_list:\t0-" << options.cpus - 1
+         << "\nvoluntary_ctxt_switches:\t" << ticks(rng)
+         << "\nnonvoluntary_ctxt_switches:\t" << ticks(rng) / 10 << '\n';
+
+  // A hybrid host: the v1 hierarchies come first, the v2 path is last
+  std::uniform_int_distribution<int> service(0, options.cgroups - 1);
+  const std::string cgroup =
+      kernel ? "/"
+             : "/system.slice/service" + std::to_string(service(rng)) +
+                   ".service";
+  std::ofstream(dir / "cgroup") << "12:memory:" << cgroup << "\n1:cpu:/\n"
+                                << "0::" << cgroup << '\n';
+
+  std::uniform_int_distribution<unsigned long long> bytes(0, 1ULL << 36);
+  const unsigned long long read = kernel ? 0 : bytes(rng);
+  const unsigned long long written = kernel ? 0 : bytes(rng);
+  std::ofstream(dir / "io") << "rchar: " << read * 2 << "\nwchar: "
+                            << written * 2 << "\nsyscr: " << read / 4096
+                            << "\nsyscw: " << written / 4096
+                            << "\nread_bytes: " << read
+                            << "\nwrite_bytes: " << written
+                            << "\ncancelled_write_bytes: 0\n";
+
+  std::ofstream cmdline(dir / "cmdline", std::ios::binary);
+  if (!kernel) {
+    const std::string argv[] = {"/usr/bin/" + comm, "--config",
+                                "/etc/" + comm + "/main.conf", "--verbose"};
+    for (const std::string& arg : argv) {
+      cmdline << arg << '\0';
+    }
+    std::filesystem::create_symlink(argv[0], dir / "exe");
+  }
+}
+
+void WriteProbe(const std::filesystem::path& proc) {
+  const ProcFixture::Probe& probe = ProcFixture::ProbeProcess();
+  const std::filesystem::path dir = proc / std::to_string(probe.pid);
+  std::filesystem::create_directory(dir);
+  std::ofstream(dir / "stat")
+      << probe.pid << " (" << probe.comm << ") " << probe.state << ' '
+      << probe.ppid << ' ' << probe.pid << ' ' << probe.pid
+      << " 0 -1 0 0 0 0 0 " << probe.utime << ' ' << probe.stime
+      << " 0 0 20 0 " << probe.numThreads << " 0 " << probe.starttime
+      << " 1048576 " << probe.rss
+      << " 18446744073709551615 0 0 0 0 0 0 0 0 0 0 0 0 17 0 0 0 0 0 0\n";
+  std::ofstream(dir / "status")
+      << "Name:\t" << probe.comm << "\nPid:\t" << probe.pid << "\nUid:\t"
+      << probe.uid << '\t' << probe.uid << '\t' << probe.uid << '\t'
+      << probe.uid << "\nVmRSS:\t" << probe.rss * 4 << " kB\n";
+  std::ofstream(dir / "cmdline", std::ios::binary) << probe.command << '\0';
+  std::ofstream(dir / "cgroup") << "0::/\n";
+  std::ofstream(dir / "io") << "read_bytes: 0\nwrite_bytes: 0\n";
+}
+
+void WritePasswd(const std::filesystem::path& etc,
+                 const ProcFixture::Options& options) {
+  std::ofstream passwd(etc / "passwd");
+  passwd << "root:x:0:0:root:/root:/bin/bash\n";
+  for (int uid = 1; uid < options.users; ++uid) {
+    passwd << "user" << uid << ":x:" << uid << ':' << uid << "::/home/user"
+           << uid << ":/bin/bash\n";
+  }
+}
+}  // namespace
+
+const ProcFixture::Probe& ProcFixture::ProbeProcess() {
+  // Above the generated pids, below the largest pid_max
+  static const Probe probe{4190000,
+                           ") (x) y",
+                           'R',
+                           1,
+                           12345,
+                           678,
+                           9,
+                           4242424242ULL,
+                           2048,
+                           1,
+                           std::string("/opt/probe\0--name\0a b", 21)};
+  return probe;
+}
+
+const std::vector<std::string>& ProcFixture::WholeDisks() {
+  static const std::vector<std::string> disks{"loop10", "nvme0n1", "sda",
+                                              "dm-0"};
+  return disks;
+}
+
+std::string ProcFixture::ProcDirectory(const std::string& root) {
+  return (std::filesystem::path(root) / "proc").string() + "/";
+}
+
+std::string ProcFixture::PasswordPath(const std::string& root) {
+  return (std::filesystem::path(root) / "etc" / "passwd").string();
+}
+
+std::string ProcFixture::CgroupDirectory(const std::string& root) {
+  return (std::filesystem::path(root) / "cgroup").string();
+}
+
+void ProcFixture::Generate(const std::string& root, const Options& options) {
+  const std::filesystem::path base{root};
+  const std::filesystem::path marker = base / kMarkerFilename;
+  {
+    std::ifstream existing(marker);
+    std::string line;
+    if (std::getline(existing, line) && line == Marker(options)) {
+      return;
+    }
+  }
+
+  std::filesystem::remove_all(base);
+  std::filesystem::create_directories(base / "proc" / "net");
+  std::filesystem::create_directories(base / "etc");
+
+  std::mt19937 rng{options.seed};
+  WriteSystemFiles(base / "proc", options, rng);
+  WritePasswd(base / "etc", options);
+  // Pids are spread out like on a long running host instead of 1..n.
+  int pid = 1;
+  for (int i = 0; i < options.pids; ++i) {
+    WriteProcess(base / "proc", pid, options, rng);
+    pid += 1 + static_cast<int>(rng() % 7);
+  }
+  WriteProbe(base / "proc");
+  WriteCgroups(base / "cgroup", options, rng);
+
+  std::ofstream(marker) << Marker(options) << '\n';
+}
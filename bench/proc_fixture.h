@@ -0,0 +1,59 @@
+#ifndef PROC_FIXTURE_H
+#define PROC_FIXTURE_H
+
+#include <string>
+#include <vector>
+
+/*
+Writes a synthetic /proc tree plus a matching passwd file, so the parser can
+be timed reproducibly against a known number of processes.
+
+Layout below root:
+  proc/{stat,uptime,meminfo,version}
+  proc/<pid>/{stat,status,cmdline,exe,cgroup,io}
+  proc/{diskstats,net/dev}
+  etc/passwd
+  cgroup/{cpu.stat,io.stat}
+  cgroup/system.slice/service<n>.service/{cpu.stat,memory.current,io.stat}
+*/
+namespace ProcFixture {
+struct Options {
+  int pids{1000};
+  int users{200};
+  int cpus{8};
+  // Services the processes are spread over, kernel threads stay in the root
+  int cgroups{50};
+  unsigned seed{42};
+};
+
+// A process written with fixed values after the generated ones, so the
+// parsers can be checked against what was written. Its comm holds spaces and
+// both parentheses, a parser splitting stat at the first ')' misreads it.
+struct Probe {
+  int pid;
+  std::string comm;
+  char state;
+  int ppid;
+  unsigned long utime;
+  unsigned long stime;
+  long numThreads;
+  unsigned long long starttime;
+  // Resident pages
+  long rss;
+  int uid;
+  // The cmdline, arguments separated by NUL
+  std::string command;
+};
+const Probe& ProbeProcess();
+// The devices of diskstats that are whole disks and did I/O, in the order
+// of the file. loop10 is one of them, not a partition of loop1.
+const std::vector<std::string>& WholeDisks();
+
+// Generate the tree unless root already holds one built with the same options
+void Generate(const std::string& root, const Options& options);
+std::string ProcDirectory(const std::string& root);
+std::string PasswordPath(const std::string& root);
+std::string CgroupDirectory(const std::string& root);
+};  // namespace ProcFixture
+
+#endif
@@ -0,0 +1,73 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "recording.h"
+#include "sample.h"
+#include "system.h"
+
+struct Options;
+
+/*
+Headless mode: samples System at a fixed interval and streams one record per
+tick to stdout or a file, for use under systemd or in a pipeline.
+*/
+namespace Batch {
+enum class Format {
+  // One JSON object per line
+  kJson,
+  // A header line, then one row per process with the tick's system values
+  kCsv,
+  // Length prefixed native endian records, see Writer::Binary()
+  kBinary
+};
+bool ParseFormat(const std::string& name, Format& format);
+
+// Serialises samples into a buffer that is reused for every record, numbers
+// are formatted with to_chars in place.
+class Writer {
+ public:
+  Writer(Format format, int fd);
+  // Serialise sample and write it out. Returns false if writing failed.
+  bool Write(const Sample& sample);
+  // The last serialised record
+  const std::string& Buffer() const;
+
+ private:
+  void Json(const Sample& sample);
+  void Csv(const Sample& sample);
+  void Binary(const Sample& sample);
+
+  void Append(const char* text);
+  void Append(char c);
+  template <typename TValue>
+  void Number(TValue value);
+  void Percent(float share);
+  void JsonString(std::string_view text);
+  void JsonCharacters(std::string_view text);
+  void JsonCommand(const std::string& command);
+  void CsvString(const std::string& text);
+  template <typename TValue>
+  void Raw(TValue value);
+  void RawString(const std::string& text);
+
+  Format format_;
+  int fd_;
+  std::string buffer_;
+  bool header_{false};
+};
+
+// Run the sampling loop configured by options, also appending every sample
+// to recorder if given. Returns the exit code.
+int Run(System& system, const Options& options,
+        Recording::Writer* recorder = nullptr);
+// Write the complete records of the history file options.dump, oldest
+// first, in options.format. Returns the exit code.
+int Dump(const Options& options);
+};  // namespace Batch
+
+#endif
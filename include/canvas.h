@@ -0,0 +1,50 @@
+#ifndef CANVAS_H
+#define CANVAS_H
+
+#include <curses.h>
+
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+/*
+Cell grid for one ncurses window that remembers the previous frame. A frame
+is drawn into the grid from scratch, then Flush() compares it with the
+previous one and hands only the runs of changed cells to the window. Cells
+not drawn in a frame come out blank, so rows vacated by a shrinking list are
+cleared as well.
+*/
+class Canvas {
+ public:
+  explicit Canvas(WINDOW* window);
+  ~Canvas();
+  Canvas(const Canvas&) = delete;
+  Canvas& operator=(const Canvas&) = delete;
+
+  int Rows() const;
+  int Columns() const;
+  // Start a new frame with every cell blank
+  void Clear();
+  // Make the next Flush() send every cell, e.g. after another window was
+  // drawn over this one
+  void Invalidate();
+  // Draw the window border with line drawing characters
+  void Box();
+  // Draw text at row, column, clipped at the right border. Returns the
+  // column after the text.
+  int Put(int row, int column, std::string_view text,
+          chtype attributes = A_NORMAL);
+  int Put(int row, int column, chtype c);
+  // Pass the changed cells to the window and mark it for the next
+  // doupdate(). Returns the number of cells passed.
+  std::size_t Flush();
+
+ private:
+  WINDOW* window_;
+  int rows_;
+  int columns_;
+  std::vector<chtype> cells_;
+  std::vector<chtype> previous_;
+};
+
+#endif
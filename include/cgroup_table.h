@@ -0,0 +1,63 @@
+#ifndef CGROUP_TABLE_H
+#define CGROUP_TABLE_H
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "linux_parser.h"
+
+/*
+Processes grouped by their cgroup v2, e.g. a container or a systemd slice.
+The cgroup of a pid is read once per (pid, starttime). The usage comes from
+the cgroup's own cpu.stat, memory.current and io.stat, so a refresh reads
+three files per cgroup, however many processes it holds.
+*/
+class CgroupTable {
+ public:
+  struct Cgroup {
+    // Relative to LinuxParser::CgroupDirectory()
+    std::string path;
+    int processes{0};
+    // Share of one CPU over the last interval
+    float cpu{0};
+    // Bytes per second over the last interval
+    double readRate{0};
+    double writeRate{0};
+    // Raw counters of the last refresh
+    LinuxParser::CgroupCounters counters;
+  };
+
+  // Whether pid is mapped and was still the process started at starttime
+  bool Known(int pid, unsigned long long starttime) const;
+  // Whether pid is mapped at all
+  bool Mapped(int pid) const;
+  // Put pid, started at starttime, into the cgroup at path
+  void Map(int pid, unsigned long long starttime, const std::string& path);
+  void Forget(int pid);
+  // Forget every pid that is not in pids, which is ascending
+  void Retain(const std::vector<int>& pids);
+  // Read the counters of every cgroup that has processes and drop the
+  // cgroups that have none left
+  void Refresh();
+  void Clear();
+  const std::vector<Cgroup>& Cgroups() const;
+
+ private:
+  struct Member {
+    unsigned long long starttime;
+    std::size_t cgroup;
+  };
+
+  std::unordered_map<int, Member> members_;
+  std::vector<Cgroup> cgroups_;
+  // path -> position in cgroups_
+  std::unordered_map<std::string, std::size_t> index_;
+  // Old position in cgroups_ -> new one, reused across refreshes
+  std::vector<std::size_t> moved_;
+  std::chrono::steady_clock::time_point lastRefresh_;
+};
+
+#endif
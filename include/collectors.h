@@ -0,0 +1,91 @@
+#ifndef COLLECTORS_H
+#define COLLECTORS_H
+
+#include <cstdint>
+#include <string>
+
+// Set by the MONITOR_COLLECTORS CMake option. A collector left out of the
+// build can not be enabled: System has neither its tables nor its steps, and
+// CMake compiles none of its sources.
+#ifndef MONITOR_COLLECT_CPU
+#define MONITOR_COLLECT_CPU 1
+#endif
+#ifndef MONITOR_COLLECT_MEMORY
+#define MONITOR_COLLECT_MEMORY 1
+#endif
+#ifndef MONITOR_COLLECT_PROCESSES
+#define MONITOR_COLLECT_PROCESSES 1
+#endif
+#ifndef MONITOR_COLLECT_IO
+#define MONITOR_COLLECT_IO 1
+#endif
+#ifndef MONITOR_COLLECT_THREADS
+#define MONITOR_COLLECT_THREADS 1
+#endif
+#ifndef MONITOR_COLLECT_CGROUPS
+#define MONITOR_COLLECT_CGROUPS 1
+#endif
+#ifndef MONITOR_COLLECT_DEVICES
+#define MONITOR_COLLECT_DEVICES 1
+#endif
+
+/*
+The groups of metrics System collects on a tick. Which ones exist is fixed
+at build time, which of those run is chosen once at startup (--collectors).
+System turns the enabled ones into a plan of steps, see System::Enable(), so
+a tick neither tests nor reads anything for a disabled collector and its
+tables stay empty.
+*/
+namespace Collectors {
+enum class Id {
+  // /proc/stat: CPU and per core load, process counts, context switches
+  kCpu,
+  // /proc/meminfo
+  kMemory,
+  // /proc/<pid>/stat of every process, the process table
+  kProcesses,
+  // /proc/<pid>/io of the selected processes, see System::IoSelection
+  kIo,
+  // /proc/<pid>/task of the selected processes, see System::ThreadSelection
+  kThreads,
+  // cgroup v2 counters, while the cgroup view is shown
+  kCgroups,
+  // /proc/diskstats and /proc/net/dev
+  kDevices,
+  kCount
+};
+using Set = std::uint32_t;
+
+constexpr Set Bit(Id id) { return Set{1} << static_cast<unsigned>(id); }
+
+// The collectors compiled in
+constexpr Set kBuilt{(MONITOR_COLLECT_CPU ? Bit(Id::kCpu) : 0) |
+                     (MONITOR_COLLECT_MEMORY ? Bit(Id::kMemory) : 0) |
+                     (MONITOR_COLLECT_PROCESSES ? Bit(Id::kProcesses) : 0) |
+                     (MONITOR_COLLECT_IO ? Bit(Id::kIo) : 0) |
+                     (MONITOR_COLLECT_THREADS ? Bit(Id::kThreads) : 0) |
+                     (MONITOR_COLLECT_CGROUPS ? Bit(Id::kCgroups) : 0) |
+                     (MONITOR_COLLECT_DEVICES ? Bit(Id::kDevices) : 0)};
+// Every collector, built or not
+constexpr Set kAll{Bit(Id::kCount) - 1};
+// The collectors that read per process files
+constexpr Set kPerProcess{Bit(Id::kProcesses) | Bit(Id::kIo) |
+                          Bit(Id::kThreads)};
+
+constexpr bool Built(Id id) { return (kBuilt & Bit(id)) != 0; }
+
+static_assert(Built(Id::kProcesses) ||
+                  !(Built(Id::kIo) || Built(Id::kThreads)),
+              "the io and threads collectors select from the process table");
+
+// "cpu", "memory", ...
+const char* Name(Id id);
+// Parse a comma separated list of names. Fails on unknown names and on
+// collectors that were not built, error says which.
+bool Parse(const std::string& names, Set& set, std::string& error);
+// set plus the collectors the ones in it build on: io and threads pick
+// their processes from the process table
+Set WithDependencies(Set set);
+};  // namespace Collectors
+
+#endif
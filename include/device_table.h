@@ -0,0 +1,65 @@
+#ifndef DEVICE_TABLE_H
+#define DEVICE_TABLE_H
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "linux_parser.h"
+
+/*
+Throughput of the block devices and network interfaces, from /proc/diskstats
+and /proc/net/dev. A refresh reads these two files, however many devices
+there are. Rates are counter deltas over the interval since the previous
+refresh.
+Partitions are left out, because the disk holding them already counts their
+I/O. So are the devices that never did any I/O, like unused loop devices.
+*/
+class DeviceTable {
+ public:
+  struct Disk {
+    std::string name;
+    // Bytes and requests per second over the last interval
+    double readRate{0};
+    double writeRate{0};
+    double iops{0};
+    // Share of the interval with at least one request in flight
+    float utilization{0};
+    // Raw counters of the last refresh
+    LinuxParser::DiskCounters counters;
+  };
+  struct Interface {
+    std::string name;
+    // Bytes per second over the last interval
+    double receiveRate{0};
+    double transmitRate{0};
+    // Raw counters of the last refresh
+    LinuxParser::NetCounters counters;
+  };
+
+  void Refresh();
+  // In the order of the files
+  const std::vector<Disk>& Disks() const;
+  const std::vector<Interface>& Interfaces() const;
+
+ private:
+  void RefreshDisks(double elapsed);
+  void RefreshInterfaces(double elapsed);
+
+  std::vector<Disk> disks_;
+  std::vector<Interface> interfaces_;
+  // Devices of the current refresh, swapped with the ones above
+  std::vector<Disk> nextDisks_;
+  std::vector<Interface> nextInterfaces_;
+  // What the files listed, reused across refreshes
+  std::vector<LinuxParser::DiskCounters> diskReads_;
+  std::vector<LinuxParser::NetCounters> interfaceReads_;
+  // Names of diskReads_ when whole_ was worked out, and per name whether it
+  // is a whole disk. Only redone when a device comes or goes.
+  std::vector<std::string> names_;
+  std::vector<char> whole_;
+  std::chrono::steady_clock::time_point lastRefresh_;
+};
+
+#endif
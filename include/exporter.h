@@ -0,0 +1,127 @@
+#ifndef EXPORTER_H
+#define EXPORTER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+#include "collectors.h"
+#include "exporter_address.h"
+#include "recording.h"
+#include "sample.h"
+#include "system.h"
+
+struct Options;
+
+/*
+Exporter mode: samples System at a fixed interval and serves the latest
+sample in the OpenMetrics text format to local scrapers such as Prometheus,
+over HTTP on a Unix domain socket or a port of 127.0.0.1.
+*/
+namespace Exporter {
+// Append the OpenMetrics exposition of sample to body. Only the families of
+// the enabled collectors are written, so a collector that is off reads as
+// absent instead of as zero.
+void Render(const Sample& sample, Collectors::Set enabled, std::string& body);
+
+/*
+Answers GET /metrics with the latest published sample. Publish() renders a
+sample once into an immutable response that every scrape of that sample
+shares: a connection holds a reference to the response it is sending and
+writes it straight from there, so a scrape neither reads /proc nor copies
+the body, and a sample published mid-response leaves the ones in flight
+alone.
+One thread runs an edge triggered epoll loop over the listening socket and
+all connections. The sockets are non-blocking, so a slow scraper only holds
+up its own response. Keep-alive and pipelined requests are supported.
+At most kMaxConnections are open at once. A sweep every second closes the
+ones that stalled, mid-request or mid-response, and long idle ones. At the
+cap or out of descriptors the listener is left out of the loop, the pending
+connections wait in the backlog until one closes or the next sweep.
+*/
+class Server {
+ public:
+  Server() = default;
+  // Stops the thread, closes the sockets and removes the Unix socket
+  ~Server();
+  Server(const Server&) = delete;
+  Server& operator=(const Server&) = delete;
+
+  // Bind address and start serving. On failure error says why.
+  bool Listen(const Address& address, std::string& error);
+  // Render sample and answer every following scrape with it
+  void Publish(const Sample& sample, Collectors::Set enabled);
+  // Responses sent completely so far
+  std::uint64_t Scrapes() const;
+
+  // One rendered response, header and body kept apart so the body is
+  // written as rendered
+  struct Response {
+    std::string header;
+    std::string body;
+  };
+
+ private:
+  struct Connection {
+    // Last accepted, answered or written to, for the sweep
+    std::chrono::steady_clock::time_point active;
+    // Received bytes of requests not answered yet
+    std::string request;
+    // Being sent, null when idle
+    std::shared_ptr<const Response> response;
+    // Bytes of header and body written so far
+    std::size_t sent{0};
+    // Close once the response is sent
+    bool close{false};
+    // The peer sent all it will, close once its requests are answered
+    bool hungUp{false};
+  };
+
+  void Loop();
+  void Accept();
+  // Watch the listener or stop accepting for now
+  void Accepting(bool accepting);
+  void Close(int fd);
+  // Close the stalled and long idle connections
+  void Sweep();
+  // Each returns false when the connection is to be closed
+  bool Receive(int fd, Connection& connection);
+  bool Serve(int fd, Connection& connection);
+  bool Send(int fd, Connection& connection);
+  // Take the next complete request off connection.request and pick its
+  // response. Returns false if no complete request is buffered.
+  bool Answer(Connection& connection);
+
+  int listener_{-1};
+  int epoll_{-1};
+  // Signalled by the destructor to end the loop
+  int wake_{-1};
+  // Ticks every second for Sweep()
+  int timer_{-1};
+  std::string path_;
+  // Owned by the loop thread
+  std::unordered_map<int, Connection> connections_;
+  bool accepting_{true};
+  std::atomic<std::uint64_t> scrapes_{0};
+
+  // Guards latest_ only, held for a pointer copy
+  std::mutex mutex_;
+  std::shared_ptr<const Response> latest_;
+  std::size_t capacity_{0};
+  std::thread thread_;
+};
+
+// Sample at options.interval and serve every sample at options.exportTo
+// until SIGINT or SIGTERM, also appending it to recorder if given. Returns
+// the exit code.
+int Run(System& system, const Options& options,
+        Recording::Writer* recorder = nullptr);
+};  // namespace Exporter
+
+#endif
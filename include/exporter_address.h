@@ -0,0 +1,18 @@
+#ifndef EXPORTER_ADDRESS_H
+#define EXPORTER_ADDRESS_H
+
+#include <string>
+
+// Where the exporter listens, apart from Exporter so Options can hold one
+// without pulling in the server
+namespace Exporter {
+// A Unix socket path, or if that is empty a TCP port on 127.0.0.1
+struct Address {
+  std::string path;
+  int port{0};
+};
+// Parse PORT, 127.0.0.1:PORT or the path of a Unix socket
+bool ParseAddress(const std::string& text, Address& address);
+};  // namespace Exporter
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef FD_CACHE_H
+#define FD_CACHE_H
+
+#include <sys/types.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+/*
+A /proc file that stays open between ticks. Every Read() is a pread() at
+offset 0, which makes the kernel generate fresh content without another
+open() and close().
+*/
+class ProcFile {
+ public:
+  ProcFile() = default;
+  ~ProcFile();
+  ProcFile(const ProcFile&) = delete;
+  ProcFile& operator=(const ProcFile&) = delete;
+
+  // Read the whole file into buffer, keeping its capacity. The descriptor is
+  // reopened only when path changes.
+  bool Read(const std::string& path, std::string& buffer);
+
+ private:
+  std::string path_;
+  int fd_{-1};
+};
+
+/*
+Open per-pid files (stat, io) of processes that are read every tick. All
+caches together hold at most half of RLIMIT_NOFILE descriptors and a file is
+cached by at most one of them. Once that budget is used up no new descriptor
+is kept: the cached ones stay, every other file is opened, read and closed
+again. Descriptors not read for a while are closed when a cache runs out, so
+exited processes give their share back. A descriptor of a process that exited
+fails with ESRCH, it is then dropped and the path is opened again in case the
+pid was reused. Not thread safe, use one cache per thread.
+*/
+class PidFileCache {
+ public:
+  PidFileCache() = default;
+  ~PidFileCache();
+  PidFileCache(const PidFileCache&) = delete;
+  PidFileCache& operator=(const PidFileCache&) = delete;
+
+  // Read up to size bytes of the file identified by key (and found at path
+  // if it is not open yet). Returns the number of bytes read or -1.
+  ssize_t Read(std::uint64_t key, const char* path, char* buffer,
+               std::size_t size);
+  void Clear();
+  std::size_t Size() const;
+
+ private:
+  struct Entry {
+    int fd;
+    bool read;
+  };
+
+  bool Admit(std::uint64_t key);
+  void Close(std::uint64_t key, int fd);
+  void Sweep();
+
+  std::unordered_map<std::uint64_t, Entry> entries_;
+  std::chrono::steady_clock::time_point swept_{};
+};
+
+#endif
@@ -1,10 +1,16 @@
 #ifndef FORMAT_H
 #define FORMAT_H
 
+#include <cstddef>
 #include <string>
 
 namespace Format {
-std::string ElapsedTime(long times);  // TODO: See src/format.cpp
-};                                    // namespace Format
+// Longest ElapsedTime() text, hours may take more than two digits
+constexpr std::size_t kElapsedTimeSize{32};
 
-#endif
\ No newline at end of file
+std::string ElapsedTime(long times);
+// Write HH:MM:SS into buffer without allocating, returns the length
+std::size_t ElapsedTime(long seconds, char (&buffer)[kElapsedTimeSize]);
+};  // namespace Format
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef METADATA_CACHE_H
+#define METADATA_CACHE_H
+
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+#include "linux_parser.h"
+#include "string_arena.h"
+
+/*
+What the monitor shows of a process that does not change while it runs:
+the command line, the executable and the user. Cached per (pid, starttime),
+so status, cmdline and exe are read once when a pid appears and again only
+when the pid is reused; a process that exec()s keeps its first command
+line. The strings are interned in a StringArena shared with the process
+table, which takes the ids from here, so a command run by many processes is
+stored once.
+Like ThreadTable the cache is ordered by pid and merged with every scan,
+so position i in it is pids[i].
+*/
+class MetadataCache {
+ public:
+  explicit MetadataCache(StringArena& strings);
+
+  // Follow a new scan, pids ascending: the entries of the pids that are
+  // gone are released, new pids start out empty
+  void Track(const std::vector<int>& pids);
+  // Whether pids[i] is cached for the process started at starttime. Safe
+  // to call from several threads until the next Track() or Store().
+  bool Current(std::size_t i, unsigned long long starttime) const;
+  // Cache the uid, command and exe snapshot read for pids[i], replacing
+  // an earlier process with that pid
+  void Store(std::size_t i, const LinuxParser::ProcessSnapshot& snapshot,
+             std::string_view user);
+  // Valid until the next Track() or Store()
+  std::string_view Command(std::size_t i) const;
+  std::string_view Exe(std::size_t i) const;
+  std::string_view User(std::size_t i) const;
+  // Ids in the shared arena, Acquire() them to keep them past Track()
+  StringArena::Id CommandId(std::size_t i) const;
+  StringArena::Id UserId(std::size_t i) const;
+  int Uid(std::size_t i) const;
+
+ private:
+  struct Entry {
+    int pid{0};
+    unsigned long long starttime{0};
+    int uid{-1};
+    StringArena::Id command{StringArena::kEmpty};
+    StringArena::Id exe{StringArena::kEmpty};
+    StringArena::Id user{StringArena::kEmpty};
+    bool cached{false};
+  };
+
+  void Release(const Entry& entry);
+
+  std::vector<Entry> entries_;
+  // The cache under construction, swapped with entries_
+  std::vector<Entry> next_;
+  StringArena* strings_;
+};
+
+#endif
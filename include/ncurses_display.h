@@ -1,16 +1,52 @@
 #ifndef NCURSES_DISPLAY_H
 #define NCURSES_DISPLAY_H
 
-#include <curses.h>
+#include <cstddef>
+#include <string_view>
+#include <vector>
 
-#include "process.h"
+#include "canvas.h"
+#include "recording.h"
+#include "replay_system.h"
+#include "sample.h"
 #include "system.h"
 
+struct Options;
+
+/*
+Interactive view. A sampler thread reads /proc every options.interval, the
+newest sample is drawn at most every options.renderInterval. Keys: q quits,
+c, m, t and i sort by CPU, memory, age and I/O, + and - shorten and lengthen the
+sampling interval, d toggles the profiling panel. The up and down arrows
+select a process, enter lists its threads under it and h switches to the
+busiest threads of all processes. g switches to the cgroups.
+*/
 namespace NCursesDisplay {
-void Display(System& system, int n = 30);
-void DisplaySystem(System& system, WINDOW* window);
-void DisplayProcesses(std::vector<Process>& processes, WINDOW* window, int n);
-std::string ProgressBar(float percent);
+// recorder, if given, receives every sample
+void Display(System& system, const Options& options,
+             Recording::Writer* recorder = nullptr);
+// Play back a recording: space pauses, + and - change the speed, the left
+// and right arrows seek by a minute, page up and down by an hour, home and
+// end jump to either end
+void Replay(ReplaySystem& system, const Options& options);
+// Draw one frame into canvas. Formatting happens in fixed buffers, nothing
+// is allocated.
+void DisplaySystem(const Sample& sample, std::string_view os,
+                   std::string_view kernel, Canvas& canvas);
+// selected: row to highlight, -1 for none. The threads of sample.expanded
+// are listed under it.
+void DisplayProcesses(const Sample& sample, Canvas& canvas, int n,
+                      int selected = -1);
+// The hot thread view, sample.threads with their processes
+void DisplayThreads(const Sample& sample, Canvas& canvas, int n);
+// The cgroup view, sample.cgroups
+void DisplayCgroups(const Sample& sample, Canvas& canvas, int n);
+// The busiest n disks and network interfaces side by side
+void DisplayDevices(const Sample& sample, Canvas& canvas, int n);
+
+// Characters ProgressBar() writes
+constexpr std::size_t kProgressBarSize{62};
+void ProgressBar(float percent, char (&buffer)[kProgressBarSize]);
 };  // namespace NCursesDisplay
 
 #endif
\ No newline at end of file
@@ -0,0 +1,79 @@
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "batch.h"
+#include "collectors.h"
+#include "exporter_address.h"
+#include "system.h"
+
+// Command line settings of the monitor
+struct Options {
+  // Rows of the process list, also the processes written per batch record
+  int top{30};
+  // Workers reading /proc, 0 for one per hardware thread
+  std::size_t threads{0};
+  System::SortColumn sort{System::SortColumn::kCpu};
+
+  // Time between two samples
+  std::chrono::milliseconds interval{1000};
+  // Shortest time between two frames of the interactive view
+  std::chrono::milliseconds renderInterval{100};
+
+  // Per thread sampling of the interactive view: --hot-threads starts in
+  // the hot thread view, --thread-threshold PCT and --all-threads pick the
+  // processes it reads
+  System::ThreadSelection threadSelection;
+  // Start in the cgroup view, see System::RefreshCgroups()
+  bool cgroups{false};
+
+  // What a tick collects, see Collectors. --collectors NAME,NAME,...
+  // enables a subset of the ones compiled in.
+  Collectors::Set collectors{Collectors::kBuilt};
+
+  // Which processes have their I/O read: --io-top N busiest by CPU and the
+  // pids of --io-watch PID,PID,...
+  System::IoSelection io;
+
+  // Which processes a tick reads, see SampleScheduler: --tiered backs off
+  // from idle processes, --budget N and --budget-us US cap the system calls
+  // and the time the reads of one tick take
+  bool tiered{false};
+  SampleScheduler::Budget budget;
+
+  // Print the Profiler table to stderr on exit
+  bool profile{false};
+
+  // Headless mode, see Batch::Run()
+  bool batch{false};
+  // Records to write, 0 runs until SIGINT or SIGTERM
+  long iterations{0};
+  Batch::Format format{Batch::Format::kJson};
+  // Empty for stdout
+  std::string output;
+
+  // Serve OpenMetrics at this address instead of showing the interface, see
+  // Exporter::Run()
+  bool exporter{false};
+  Exporter::Address exportTo;
+
+  // History file, see Recording::Writer. Empty records nothing.
+  std::string record;
+  // Samples kept in the history, the last hour at the default interval
+  std::uint32_t recordSlots{3600};
+  // History file to play back in the ncurses interface, see ReplaySystem
+  std::string replay;
+  // History file to write out in format instead of sampling, see Batch::Dump()
+  std::string dump;
+};
+
+// Fill options from argv. On failure error describes the problem.
+bool ParseOptions(int argc, char* argv[], Options& options,
+                  std::string& error);
+std::string Usage(const std::string& program);
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef PID_SCANNER_H
+#define PID_SCANNER_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/*
+Lists the pids in /proc with raw getdents64() calls into one reusable
+buffer. The directory stays open between scans and is rewound instead of
+reopened, names are parsed in place and nothing is stat()ed. A scan can be
+compared with the previous one, so callers only need to do the full work
+for the pids that appeared; the comparison is made on the first Added() or
+Removed() after a scan, scanners that never ask do not pay for it.
+Not thread safe, use one scanner per thread.
+*/
+class PidScanner {
+ public:
+  PidScanner() = default;
+  ~PidScanner();
+  PidScanner(const PidScanner&) = delete;
+  PidScanner& operator=(const PidScanner&) = delete;
+
+  // Read the pids in directory. The directory is reopened only when it
+  // changes. Returns false, with no pids, if it cannot be read.
+  bool Scan(const std::string& directory);
+  // Forget the previous scan, so the next one reports every pid as added
+  void Reset();
+  // Ascending
+  const std::vector<int>& Pids() const;
+  // Pids of this scan missing from the previous one, ascending
+  const std::vector<int>& Added();
+  // Pids of the previous scan missing from this one, ascending
+  const std::vector<int>& Removed();
+
+ private:
+  static constexpr std::size_t kBufferSize{1 << 16};
+
+  void Diff();
+
+  std::string directory_;
+  int fd_{-1};
+  std::vector<char> buffer_;
+  std::vector<int> pids_;
+  std::vector<int> previous_;
+  std::vector<int> added_;
+  std::vector<int> removed_;
+  // Whether added_ and removed_ belong to the last scan
+  bool diffed_{true};
+};
+
+#endif
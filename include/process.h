@@ -2,29 +2,42 @@
 #define PROCESS_H
 
 #include <string>
+#include <string_view>
+
 /*
-Basic class for Process representation
-It contains relevant attributes as shown below
+A copy of the values System shows of one process, e.g. in a Sample that
+another thread draws. System itself keeps its processes in a ProcessTable.
 */
 class Process {
  public:
-  Process(int pid);
-  int Pid() const;                         // TODO: See src/process.cpp
-  std::string User() const;                // TODO: See src/process.cpp
-  std::string Command() const;             // TODO: See src/process.cpp
-  float CpuUtilization() const;            // TODO: See src/process.cpp
-  std::string Ram() const;                 // TODO: See src/process.cpp
-  long int UpTime() const;                 // TODO: See src/process.cpp
-  bool operator<(Process const& a) const;  // TODO: See src/process.cpp
+  // Values of a process, e.g. from a recording
+  // readRate and writeRate: storage I/O in bytes per second
+  Process(int pid, std::string user, std::string command, float cpu,
+          long ramMb, long uptime, float readRate, float writeRate);
+  // Take other values, keeping the string buffers
+  void Assign(int pid, std::string_view user, std::string_view command,
+              float cpu, long ramMb, long uptime, float readRate,
+              float writeRate);
+  int Pid() const;
+  const std::string& User() const;
+  const std::string& Command() const;
+  float CpuUtilization() const;
+  std::string Ram() const;
+  long int RamMb() const;
+  long int UpTime() const;
+  float ReadRate() const;
+  float WriteRate() const;
+  bool operator<(Process const& a) const;
 
  private:
   int pid_;
   long int ram_;
-  double cpuUtilization_;
+  double cpuUtilization_{0};
   long int uptime_;
+  float readRate_;
+  float writeRate_;
   std::string command_;
   std::string user_;
-  static constexpr size_t MAX_COMMAND_LENGTH{50};
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,128 @@
+#ifndef PROCESS_TABLE_H
+#define PROCESS_TABLE_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "linux_parser.h"
+#include "process.h"
+#include "string_arena.h"
+
+/*
+The process store of System, one array per field. Sorting by CPU walks 4
+bytes per process instead of whole Process objects with two strings each,
+and 100k processes fit in a few MB. Commands and users are ids into the
+StringArena the table shares with MetadataCache, a row holds no heap memory
+of its own.
+Rows are ordered by pid. Every refresh builds the next table by merging the
+scan into the current one (Begin(), then Keep(), Update(), Add() or Drop()
+for each row in pid order, then Commit()), so the arrays are only ever
+written front to back and their capacity is reused.
+*/
+class ProcessTable {
+ public:
+  // One row, with the accessors of Process. Valid until the next Commit().
+  class Row {
+   public:
+    Row(const ProcessTable& table, std::size_t row);
+    int Pid() const;
+    std::string_view User() const;
+    std::string_view Command() const;
+    float CpuUtilization() const;
+    std::string Ram() const;
+    long int RamMb() const;
+    long int UpTime() const;
+    // Bytes per second, 0 unless SampleIo() read the process this refresh
+    float ReadRate() const;
+    float WriteRate() const;
+
+   private:
+    const ProcessTable* table_;
+    std::uint32_t row_;
+  };
+
+  explicit ProcessTable(StringArena& strings);
+
+  std::size_t Size() const;
+  Row operator[](std::size_t row) const;
+  // Row of pid, Size() if there is none
+  std::size_t Find(int pid) const;
+  // The columns, ordered like the rows
+  const std::vector<int>& Pids() const;
+  // In clock ticks after boot, 0 for a recorded process
+  const std::vector<unsigned long long>& Starttime() const;
+  const std::vector<float>& Cpu() const;
+  const std::vector<long>& RamMb() const;
+  const std::vector<long>& UpTime() const;
+  const std::vector<float>& ReadRate() const;
+  const std::vector<float>& WriteRate() const;
+
+  // Whether snapshot was taken of the process in row and not of a later
+  // one that got the same pid
+  bool SameProcess(std::size_t row,
+                   const LinuxParser::ProcessSnapshot& snapshot) const;
+
+  // Start the next table
+  void Begin();
+  // Carry row over without a new sample, only its age changes
+  void Keep(std::size_t row, long systemUptime);
+  // Carry row over with a new sample. The CPU utilization is the share of
+  // elapsedSeconds the process spent running since the previous sample,
+  // like top computes it, at full clock tick resolution.
+  void Update(std::size_t row, const LinuxParser::ProcessSnapshot& snapshot,
+              long systemUptime, double elapsedSeconds);
+  // Append a process seen for the first time, taking a reference to the
+  // command and user ids
+  void Add(const LinuxParser::ProcessSnapshot& snapshot,
+           StringArena::Id command, StringArena::Id user, long systemUptime);
+  // Leave row out of the next table
+  void Drop(std::size_t row);
+  // Replace the table with the next one
+  void Commit();
+  // Replace the table with recorded processes
+  void Assign(const std::vector<Process>& processes);
+  // Set the I/O rates of row, in the current table, from the change since
+  // its previous /proc/<pid>/io sample. A process sampled for the first
+  // time gets its lifetime average.
+  void SampleIo(std::size_t row, const LinuxParser::IoCounters& io,
+                std::chrono::steady_clock::time_point now);
+
+ private:
+  struct Columns {
+    std::vector<int> pid;
+    // Identifies a process together with its pid, pids get reused
+    std::vector<unsigned long long> starttime;
+    // utime + stime of the last sample, in clock ticks
+    std::vector<unsigned long> activeJiffies;
+    std::vector<float> cpu;
+    std::vector<long> ramMb;
+    // Age in seconds
+    std::vector<long> uptime;
+    std::vector<StringArena::Id> command;
+    std::vector<StringArena::Id> user;
+    // The last /proc/<pid>/io sample and when it was taken, carried along
+    // with the row, and the rates it gave. The rates are cleared for every
+    // new table.
+    std::vector<LinuxParser::IoCounters> io;
+    std::vector<std::chrono::steady_clock::time_point> ioSampled;
+    std::vector<float> readRate;
+    std::vector<float> writeRate;
+
+    void Clear();
+  };
+
+  // Append row of current_ to next_
+  void Copy(std::size_t row);
+  // Append the I/O columns of a new row to next_
+  void AddIo();
+
+  Columns current_;
+  Columns next_;
+  StringArena* strings_;
+};
+
+#endif
@@ -1,14 +1,32 @@
 #ifndef PROCESSOR_H
 #define PROCESSOR_H
 
+#include <vector>
+
+#include "linux_parser.h"
+
+/*
+Aggregate and per core CPU utilization. The jiffies of all cpus are kept as
+parallel arrays, so the utilization of every core is computed by the same
+loop. Fed by System once per tick from its /proc/stat snapshot.
+*/
 class Processor {
  public:
-  float Utilization();
+  // Take a new sample, the values below cover the time since the last one
+  void Update(const LinuxParser::CpuJiffies& jiffies);
+  // Take values computed earlier, e.g. from a recording
+  void Assign(float utilization, float steal, const std::vector<float>& cores);
+  float Utilization() const;
+  // Share of time taken by the hypervisor (steal), part of Utilization()
+  float Steal() const;
+  const std::vector<float>& CoreUtilization() const;
 
  private:
-  long totalTime_;
-  long activeTime_;
-  long idleTime_;
+  LinuxParser::CpuJiffies previous_;
+  // Index 0 is the aggregate, like in LinuxParser::CpuJiffies
+  std::vector<float> utilization_;
+  std::vector<float> steal_;
+  std::vector<float> cores_;
 };
 
-#endif
\ No newline at end of file
+#endif
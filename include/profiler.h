@@ -0,0 +1,112 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Set by the MONITOR_PROFILING CMake option. Without it PROFILE_SCOPE()
+// expands to nothing and allocations are not counted.
+#ifndef MONITOR_PROFILING
+#define MONITOR_PROFILING 0
+#endif
+
+/*
+The monitor's own cost per phase. Scoped timers record durations into fixed
+bucket histograms that any thread may update; once per tick the number of
+allocations and read/write system calls since the previous tick is recorded
+as well.
+*/
+namespace Profiler {
+enum class Metric {
+  // Durations in nanoseconds, each phase timed as a whole once per tick
+  kTick,
+  kPids,
+  kParse,
+  kIo,
+  kThreads,
+  kCgroups,
+  kPasswd,
+  kSort,
+  kRender,
+  // Counts per tick
+  kAllocations,
+  kSyscalls,
+  // Processes read by System::Processes()
+  kReads,
+  kCount
+};
+
+// Log-linear buckets: four per power of two, so a percentile is off by at
+// most 25%. Values of 2^48 and more share the last bucket.
+class Histogram {
+ public:
+  static constexpr std::size_t kBuckets{4 * 48};
+
+  void Record(std::uint64_t value);
+  void Reset();
+  std::uint64_t Count() const;
+  // Return the upper bound of the bucket holding the given share (0..1)
+  std::uint64_t Percentile(double share) const;
+  std::uint64_t Max() const;
+
+ private:
+  std::atomic<std::uint64_t> buckets_[kBuckets]{};
+  std::atomic<std::uint64_t> count_{0};
+  std::atomic<std::uint64_t> max_{0};
+};
+
+const char* Name(Metric metric);
+// "ns" or "" for counts
+const char* Unit(Metric metric);
+Histogram& Get(Metric metric);
+// Whether the hooks were compiled in
+constexpr bool Enabled() { return MONITOR_PROFILING != 0; }
+
+// Record the allocations and system calls since the last call. Call once
+// per tick, from one thread.
+void EndTick();
+// The table of every metric: a header row, then count, p50, p99 and max of
+// one metric per row
+constexpr int kRows{static_cast<int>(Metric::kCount) + 1};
+constexpr std::size_t kRowSize{64};
+// Format row of the table into buffer without allocating, returns the
+// length like snprintf
+std::size_t FormatRow(int row, char* buffer, std::size_t size);
+// Return the whole table
+std::string Report();
+
+// Records the lifetime of the scope into a histogram
+class ScopedTimer {
+ public:
+  explicit ScopedTimer(Metric metric)
+      : metric_(metric), start_(std::chrono::steady_clock::now()) {}
+  ~ScopedTimer() {
+    Get(metric_).Record(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            std::chrono::steady_clock::now() - start_)
+                            .count());
+  }
+  ScopedTimer(const ScopedTimer&) = delete;
+  ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+ private:
+  Metric metric_;
+  std::chrono::steady_clock::time_point start_;
+};
+};  // namespace Profiler
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#if MONITOR_PROFILING
+// Time the rest of the enclosing scope into Profiler::Metric::metric
+#define PROFILE_SCOPE(metric)                                  \
+  ::Profiler::ScopedTimer PROFILE_CONCAT(profileScope, __LINE__) { \
+    ::Profiler::Metric::metric                                 \
+  }
+#else
+#define PROFILE_SCOPE(metric) static_cast<void>(0)
+#endif
+
+#endif
@@ -0,0 +1,127 @@
+#ifndef RECORDING_H
+#define RECORDING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "sample.h"
+
+/*
+History of samples in a memory-mapped circular file. The file is a
+FileHeader followed by a fixed number of equally sized slots, each holding
+one sample: a SlotHeader, the per core values and the top processes. Every
+record lives at a fixed offset, so readers map the file and use it as is.
+
+Each slot carries a sequence number that is odd while the slot is written
+and even once it is complete. Readers (also other processes, or a post
+mortem after a crash) skip slots that are odd or change while they copy them.
+*/
+namespace Recording {
+constexpr char kMagic[8] = {'M', 'O', 'N', 'H', 'I', 'S', 'T', '\0'};
+constexpr std::uint32_t kVersion{4};
+
+struct FileHeader {
+  char magic[8];
+  std::uint32_t version;
+  // Bytes per slot, including the SlotHeader
+  std::uint32_t slotSize;
+  std::uint32_t slots;
+  // Capacity of the per core and per process arrays of a slot
+  std::uint32_t cores;
+  std::uint32_t processes;
+  std::uint32_t reserved;
+  // Offset of the first slot
+  std::uint64_t dataOffset;
+};
+
+struct SlotHeader {
+  // 0 for a slot never written, 2n + 1 while record n is written and 2n + 2
+  // once it is complete
+  std::atomic<std::uint64_t> sequence;
+  std::uint64_t tick;
+  std::int64_t timestamp;
+  float cpu;
+  float steal;
+  float memory;
+  // Valid entries of the arrays following this header
+  std::uint32_t coreCount;
+  std::uint32_t processCount;
+  std::int32_t totalProcesses;
+  std::int32_t runningProcesses;
+  std::uint32_t reserved;
+  std::int64_t uptime;
+  std::uint64_t contextSwitches;
+  std::uint64_t interrupts;
+};
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free,
+              "slot sequence numbers must be lock free to live in a mapping");
+
+// Strings are NUL padded. Slots have a fixed size, so longer ones are cut
+// at the field size, which is meant for the data, not for the display.
+struct ProcessRecord {
+  std::int32_t pid;
+  float cpu;
+  std::int64_t ramMb;
+  std::int64_t uptime;
+  // Storage I/O in bytes per second
+  float readRate;
+  float writeRate;
+  // Bytes of command in use, its arguments are separated by NUL
+  std::uint32_t commandLength;
+  char user[32];
+  char command[256];
+};
+
+// Appends samples to a recording. Append() touches only the mapping, no
+// locks and no system calls, so it can run on the sampling thread.
+class Writer {
+ public:
+  Writer() = default;
+  ~Writer();
+  Writer(const Writer&) = delete;
+  Writer& operator=(const Writer&) = delete;
+
+  // Map the recording at path, creating it if needed. A file with another
+  // layout is started over, otherwise recording continues after its newest
+  // record. On failure error describes the problem.
+  bool Open(const std::string& path, std::uint32_t slots, std::uint32_t cores,
+            std::uint32_t processes, std::string& error);
+  // Store sample in the oldest slot. Values beyond the slot capacity are
+  // dropped.
+  void Append(const Sample& sample);
+
+ private:
+  char* base_{nullptr};
+  std::size_t size_{0};
+  // Number of the next record
+  std::uint64_t next_{0};
+};
+
+// Read only view of a recording, possibly one that is still being written.
+class Reader {
+ public:
+  Reader() = default;
+  ~Reader();
+  Reader(const Reader&) = delete;
+  Reader& operator=(const Reader&) = delete;
+
+  bool Open(const std::string& path, std::string& error);
+  std::uint32_t Slots() const;
+  // Return the number of records written so far. The file holds at most the
+  // last Slots() of them.
+  std::uint64_t Records() const;
+  // Get the timestamp of record without copying the rest of it
+  bool Timestamp(std::uint64_t record, std::int64_t& timestamp) const;
+  // Copy record into sample. Returns false for a record that was not
+  // written, was torn by a crash or got overwritten while copying.
+  bool Read(std::uint64_t record, Sample& sample) const;
+
+ private:
+  const char* base_{nullptr};
+  std::size_t size_{0};
+};
+};  // namespace Recording
+
+#endif
@@ -0,0 +1,74 @@
+#ifndef REPLAY_SYSTEM_H
+#define REPLAY_SYSTEM_H
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "recording.h"
+#include "sample.h"
+#include "system.h"
+
+/*
+System backed by a recording (see Recording::Writer) instead of /proc. Each
+Refresh() moves a playback clock forward by the elapsed time times the
+speed and loads the last record at or before it, so NCursesDisplay shows the
+history exactly like a live system. Seeking goes through a sparse index of
+the timestamp of every kIndexStride-th record.
+*/
+class ReplaySystem : public System {
+ public:
+  ReplaySystem();
+  bool Open(const std::string& path, std::string& error);
+
+  void Refresh() override;
+  const ProcessTable& Processes() override;
+  float MemoryUtilization() override;
+  long UpTime() override;
+  const std::string& Kernel() override;
+  const std::string& OperatingSystem() override;
+
+  void TogglePause();
+  bool Paused() const;
+  // Playback speed, clamped to 1x .. 100x
+  void SetSpeed(double speed);
+  double Speed() const;
+  // Move the playback clock by delta, staying within the recording
+  void Seek(std::chrono::milliseconds delta);
+  // Jump to the last record at or before timestamp (ms since the epoch)
+  void SeekTo(std::int64_t timestamp);
+  // Timestamps of the oldest and newest record and of the one shown
+  std::int64_t Begin() const;
+  std::int64_t End() const;
+  std::int64_t Timestamp() const;
+
+  static constexpr std::uint64_t kIndexStride{64};
+
+ private:
+  // Make record the one shown
+  void Show(std::uint64_t record);
+
+  Recording::Reader reader_;
+  std::string path_;
+  std::string kernel_{"not recorded"};
+  std::string operatingSystem_;
+  // Records first_ .. last_ are in the file
+  std::uint64_t first_{0};
+  std::uint64_t last_{0};
+  std::int64_t begin_{0};
+  std::int64_t end_{0};
+  // (timestamp, record), ascending
+  std::vector<std::pair<std::int64_t, std::uint64_t>> timeIndex_;
+  std::uint64_t position_{0};
+  bool loaded_{false};
+  Sample sample_;
+  // Playback position in recording time
+  std::int64_t clock_{0};
+  std::chrono::steady_clock::time_point lastTick_;
+  double speed_{1};
+  bool paused_{false};
+};
+
+#endif
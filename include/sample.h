@@ -0,0 +1,82 @@
+#ifndef SAMPLE_H
+#define SAMPLE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "process.h"
+
+// One thread and the process it belongs to
+struct ThreadSample {
+  int tid{0};
+  int pid{0};
+  float cpu{0};
+  std::string name;
+  // Command of the owning process
+  std::string command;
+};
+
+// One cgroup v2 and the processes in it
+struct CgroupSample {
+  std::string path;
+  int processes{0};
+  float cpu{0};
+  long memoryMb{0};
+  // Bytes per second
+  double readRate{0};
+  double writeRate{0};
+};
+
+// One block device, partitions are not listed
+struct DiskSample {
+  std::string name;
+  // Bytes and requests per second
+  double readRate{0};
+  double writeRate{0};
+  double iops{0};
+  float utilization{0};
+};
+
+// One network interface
+struct InterfaceSample {
+  std::string name;
+  // Bytes per second
+  double receiveRate{0};
+  double transmitRate{0};
+};
+
+/*
+Everything the monitor shows or exports for one tick, copied out of System
+so it can be serialised or handed to another thread.
+*/
+struct Sample {
+  std::uint64_t tick{0};
+  // Wall clock time of the sample in milliseconds since the epoch
+  std::int64_t timestamp{0};
+  float cpu{0};
+  float steal{0};
+  float memory{0};
+  long uptime{0};
+  int totalProcesses{0};
+  int runningProcesses{0};
+  unsigned long long contextSwitches{0};
+  unsigned long long interrupts{0};
+  std::vector<float> cores;
+  // The top processes in the current sort order
+  std::vector<Process> processes;
+  // Busiest first: the threads of the expanded process, or with hotThreads
+  // the busiest threads of all processes sampled per thread. Not recorded.
+  std::vector<ThreadSample> threads;
+  int expanded{0};
+  bool hotThreads{false};
+  // The top cgroups in the current sort order, filled with cgroupView set.
+  // Not recorded.
+  std::vector<CgroupSample> cgroups;
+  bool cgroupView{false};
+  // Busiest first. Not recorded.
+  std::vector<DiskSample> disks;
+  std::vector<InterfaceSample> interfaces;
+};
+
+#endif
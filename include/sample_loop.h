@@ -0,0 +1,35 @@
+#ifndef SAMPLE_LOOP_H
+#define SAMPLE_LOOP_H
+
+#include <functional>
+
+#include "recording.h"
+#include "sample.h"
+#include "system.h"
+
+struct Options;
+
+/*
+The fixed interval sampling of the headless modes, and the stop flag every
+mode watches. SIGINT and SIGTERM only set the flag. The handler is installed
+without SA_RESTART, so a signal also cuts a blocking wait short.
+*/
+namespace SampleLoop {
+// Make SIGINT and SIGTERM set StopRequested() instead of ending the process
+void CatchStopSignals();
+// Whether SIGINT or SIGTERM arrived since CatchStopSignals()
+bool StopRequested();
+
+// Handed every sample, returns false to end the loop
+using Consumer = std::function<bool(const Sample& sample)>;
+
+// Collect a baseline, then collect and capture options.top processes every
+// options.interval until a stop signal, or until iterations samples if that
+// is not 0. Each sample is appended to recorder if given and then handed to
+// consume. A tick that overruns skips the missed ones instead of sampling in
+// a burst, their number is reported on stderr at the end.
+void Run(System& system, const Options& options, long iterations,
+         Recording::Writer* recorder, const Consumer& consume);
+};  // namespace SampleLoop
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef SAMPLE_SCHEDULER_H
+#define SAMPLE_SCHEDULER_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+Decides which processes System reads on a tick. Most processes sleep, so
+when tiered a process whose CPU time did not advance since its last read
+waits twice as many ticks before the next one, up to kMaxInterval, while a
+busy or new process is read on every tick.
+A budget caps the reads of one tick. Over it the busy processes go first,
+then the new ones, then the idle ones, but a process moves up the longer it
+is overdue, so nothing starves. CPU time
+that /proc/stat reports but the process table does not explain makes every
+backed off process due again; the part that remains after a tick that read
+everything (interrupts, processes that already exited) is the noise floor.
+The schedule is ordered by pid and merged with every scan, like
+ThreadTable, so positions in it match positions in the pid list.
+*/
+class SampleScheduler {
+ public:
+  // Limits per tick, 0 for none
+  struct Budget {
+    // System calls of the reads, estimated per process
+    std::size_t syscalls{0};
+    // Time the reads take, estimated from the previous ticks
+    std::chrono::microseconds time{0};
+  };
+
+  // Without tiered every process is due on every tick. The budget applies
+  // either way, the processes it skips move up the longer they wait.
+  void Configure(bool tiered, const Budget& budget);
+  bool Tiered() const;
+  // Start a tick and return the positions in pids (ascending) to read
+  const std::vector<std::uint32_t>& Plan(const std::vector<int>& pids);
+  // Record the read of pids[i] and return the seconds since its previous
+  // read of the same process, 0 for none
+  double Sampled(std::size_t i, unsigned long long starttime,
+                 unsigned long activeJiffies,
+                 std::chrono::steady_clock::time_point now);
+  // Record how long the reads of Plan() took
+  void Spent(std::chrono::nanoseconds time);
+  // Record the busy CPU of the interval, in CPUs, that the process table
+  // does not account for
+  void Unexplained(float cpu);
+
+ private:
+  // In ticks
+  static constexpr std::uint32_t kMaxInterval{16};
+  // Unexplained CPU above the noise floor that wakes every process
+  static constexpr float kWakeCpu{0.25f};
+  // Estimated system calls of a read, see LinuxParser::ReadProcess(): a
+  // pread() of stat, and on the first read its open() plus opening,
+  // reading and closing status and cmdline and a readlink() of exe
+  static constexpr std::size_t kReadSyscalls{1};
+  static constexpr std::size_t kFirstReadSyscalls{9};
+
+  struct Entry {
+    int pid{0};
+    unsigned long long starttime{0};
+    unsigned long activeJiffies{0};
+    std::chrono::steady_clock::time_point lastRead;
+    // Tick the process is due on
+    std::uint64_t due{0};
+    std::uint32_t interval{1};
+    bool read{false};
+    // Whether the last read found new CPU time
+    bool active{false};
+  };
+
+  bool tiered_{false};
+  Budget budget_;
+  std::uint64_t tick_{0};
+  std::vector<Entry> entries_;
+  // The schedule under construction, swapped with entries_
+  std::vector<Entry> next_;
+  std::vector<std::uint32_t> planned_;
+  // Nanoseconds per read, moving average
+  double readCost_{0};
+  float noiseFloor_{0};
+  // Whether the last tick read every process
+  bool complete_{false};
+  bool wake_{false};
+};
+
+#endif
@@ -0,0 +1,86 @@
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+#include "recording.h"
+#include "sample.h"
+#include "system.h"
+
+/*
+Samples System on a background thread and publishes every result as a
+Sample, so a slow /proc scan never stalls the interface. The hand-off is a
+triple buffer: the sampler fills its back buffer and swaps it with the
+shared middle one in a single atomic exchange, the reader swaps the middle
+one with its front buffer the same way. Neither side waits for the other
+and a published sample is never modified while the reader holds it.
+
+The mutex only guards the controls (interval, sort column, thread selection,
+cgroup view, stop) and lets the sampler sleep until the next tick or a
+change of them.
+*/
+class Sampler {
+ public:
+  // recorder, if given, receives every sample
+  Sampler(System& system, std::size_t top, std::chrono::milliseconds interval,
+          Recording::Writer* recorder = nullptr);
+  // Stops the sampling thread
+  ~Sampler();
+  Sampler(const Sampler&) = delete;
+  Sampler& operator=(const Sampler&) = delete;
+
+  // Return the newest sample if one was published since the last call,
+  // nullptr otherwise. The sample stays valid until the next call.
+  const Sample* Latest();
+
+  void SetInterval(std::chrono::milliseconds interval);
+  std::chrono::milliseconds Interval() const;
+  // Reorder the current table right away, not only on the next tick
+  void SortBy(System::SortColumn column);
+  System::SortColumn SortedBy() const;
+  // Read the newly selected threads right away
+  void SelectThreads(const System::ThreadSelection& selection);
+  System::ThreadSelection SelectedThreads() const;
+  // Switch to the cgroup view, see System::RefreshCgroups(). Unless
+  // recording, its ticks skip the per process reads.
+  void ShowCgroups(bool show);
+  bool ShowingCgroups() const;
+
+ private:
+  // Set in the middle buffer index when the reader has not taken it yet
+  static constexpr unsigned kFresh{4};
+
+  void Loop();
+  void Publish();
+
+  System& system_;
+  std::size_t top_;
+  Recording::Writer* recorder_;
+
+  Sample buffers_[3];
+  // Owned by the sampler thread
+  unsigned back_{0};
+  std::atomic<unsigned> middle_{1};
+  // Owned by the reader
+  unsigned front_{2};
+
+  mutable std::mutex mutex_;
+  std::condition_variable wake_;
+  std::chrono::milliseconds interval_;
+  System::SortColumn sortColumn_;
+  System::ThreadSelection threadSelection_;
+  bool showCgroups_;
+  // Set by a control that needs a new capture before the next tick
+  bool resort_{false};
+  bool reselect_{false};
+  bool stop_{false};
+  std::thread thread_;
+};
+
+#endif
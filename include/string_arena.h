@@ -0,0 +1,65 @@
+#ifndef STRING_ARENA_H
+#define STRING_ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+/*
+Interned strings in one growing buffer. Equal strings are stored once and
+named by a stable id, so nobody holds a pointer into the buffer and it may
+grow or be compacted at any time. Strings are reference counted; once the
+released ones make up most of the buffer the live ones are packed to its
+front. The lookup is an open addressing table of ids, so interning a string
+that is already stored allocates nothing.
+Not thread safe.
+*/
+class StringArena {
+ public:
+  using Id = std::uint32_t;
+  // The empty string, never stored
+  static constexpr Id kEmpty{0};
+
+  StringArena();
+  // Return the id of text, storing it on first use. Takes a reference.
+  Id Intern(std::string_view text);
+  // Take another reference to an id returned by Intern()
+  void Acquire(Id id);
+  // Drop a reference taken by Intern()
+  void Release(Id id);
+  // Valid until the next Intern() or Release()
+  std::string_view View(Id id) const;
+  // Bytes of the buffer, released strings included
+  std::size_t Size() const;
+
+ private:
+  // Slot of a released id in the lookup table
+  static constexpr Id kTombstone{~Id{0}};
+  // Smallest buffer worth compacting
+  static constexpr std::size_t kCompactSize{1 << 16};
+
+  struct Entry {
+    std::uint32_t offset{0};
+    std::uint32_t length{0};
+    std::uint32_t references{0};
+    std::size_t hash{0};
+  };
+
+  void Rehash(std::size_t slots);
+  void Compact();
+
+  std::vector<char> buffer_;
+  // Indexed by id
+  std::vector<Entry> entries_;
+  // Released ids, reused before new ones
+  std::vector<Id> free_;
+  // Ids by hash, linear probing, the size is a power of two
+  std::vector<Id> slots_;
+  std::size_t live_{0};
+  std::size_t tombstones_{0};
+  // Bytes of released strings still in buffer_
+  std::size_t garbage_{0};
+};
+
+#endif
@@ -1,27 +1,222 @@
 #ifndef SYSTEM_H
 #define SYSTEM_H
 
+#include <cstdint>
 #include <string>
+#include <utility>
 #include <vector>
 
-#include "process.h"
+#include "collectors.h"
+#include "linux_parser.h"
+#include "process_table.h"
 #include "processor.h"
+#include "sample_scheduler.h"
+#include "string_arena.h"
+#if MONITOR_COLLECT_PROCESSES
+#include "metadata_cache.h"
+#endif
+#if MONITOR_COLLECT_PROCESSES || MONITOR_COLLECT_CGROUPS
+#include "pid_scanner.h"
+#include "worker_pool.h"
+#endif
+#if MONITOR_COLLECT_THREADS
+#include "thread_table.h"
+#endif
+#if MONITOR_COLLECT_CGROUPS
+#include "cgroup_table.h"
+#endif
+#if MONITOR_COLLECT_DEVICES
+#include "device_table.h"
+#endif
+
+struct Sample;
 
 class System {
  public:
+  enum class SortColumn { kCpu, kRam, kTime, kIo };
+  // Which processes RefreshThreads() reads per thread
+  struct ThreadSelection {
+    // Show the busiest threads instead of the processes
+    bool hot{false};
+    // Process whose threads are listed under it, 0 for none
+    int expanded{0};
+    // In the hot view, processes using at least this share of one CPU...
+    float threshold{0.1f};
+    // ...or every process if set
+    bool all{false};
+  };
+
+  // Which processes Processes() reads /proc/<pid>/io for. Only these have
+  // I/O rates, sorting by kIo ranks them among each other.
+  struct IoSelection {
+    // The busiest processes by CPU...
+    std::size_t top{10};
+    // ...and these
+    std::vector<int> watched;
+  };
+
+  // threads: workers reading /proc in parallel, 0 for one per hardware thread
+  explicit System(std::size_t threads = 0);
+  virtual ~System() = default;
+  // Choose the collectors Collect() runs and Capture() copies, among the
+  // built ones; the ones they depend on are added. All built ones by default.
+  void Enable(Collectors::Set set);
+  Collectors::Set Enabled() const;
+  // Run the enabled collectors, one tick's worth: the /proc/stat snapshot,
+  // the devices, the process table, the process I/O, the threads and the
+  // cgroups, in this order
+  void Collect();
+  // Run only the enabled collectors that are in set
+  void Collect(Collectors::Set set);
+
+  // The steps Collect() runs, also usable on their own. The ones of a
+  // collector left out of the build do nothing.
+  // Read /proc/stat once for this tick and update the CPU and counters
+  virtual void Refresh();
+  // Read the disk and network counters
+  void RefreshDevices();
+  const LinuxParser::StatSnapshot& Stat() const;
   Processor& Cpu();                   // TODO: See src/system.cpp
-  std::vector<Process>& Processes();  // TODO: See src/system.cpp
-  float MemoryUtilization();          // TODO: See src/system.cpp
-  long UpTime();                      // TODO: See src/system.cpp
-  int TotalProcesses();               // TODO: See src/system.cpp
-  int RunningProcesses();             // TODO: See src/system.cpp
-  std::string Kernel();               // TODO: See src/system.cpp
-  std::string OperatingSystem();      // TODO: See src/system.cpp
-
-  // TODO: Define any necessary private members
+  virtual const ProcessTable& Processes();
+  // Read only the processes SampleScheduler picks on each Processes(), see
+  // there. Every process is read on every tick by default.
+  void ScheduleReads(bool tiered, const SampleScheduler::Budget& budget);
+  void SortBy(SortColumn column);
+  SortColumn SortedBy() const;
+  // The rows are valid until the next Processes()
+  const std::vector<ProcessTable::Row>& TopProcesses(std::size_t n);
+  std::vector<ProcessTable::Row> SortedProcesses();
+  // Read /proc/<pid>/io of the selected processes. Call after Processes().
+  void RefreshIo();
+  void SelectIo(const IoSelection& selection);
+  const IoSelection& SelectedIo() const;
+  void SelectThreads(const ThreadSelection& selection);
+  const ThreadSelection& SelectedThreads() const;
+  // Read the threads of the selected processes. Call after Processes().
+  void RefreshThreads();
+  // Group the processes by cgroup v2 on RefreshCgroups()
+  void ShowCgroups(bool show);
+  bool ShowingCgroups() const;
+  // Map the new pids to their cgroups and read the counters of every
+  // cgroup. Does not need Processes(), which makes it the cheap way to
+  // follow a busy host.
+  void RefreshCgroups();
+  // Copy the current values of the enabled collectors and the top processes
+  // into sample. Call after Collect(). Reuses the buffers sample already
+  // holds.
+  void Capture(Sample& sample, std::size_t top);
+  virtual float MemoryUtilization();
+  virtual long UpTime();
+  int TotalProcesses();
+  int RunningProcesses();
+  // Read once, neither changes while the monitor runs
+  virtual const std::string& Kernel();
+  virtual const std::string& OperatingSystem();
+
+ protected:
+  // Show sample instead of the values read from /proc
+  void Load(const Sample& sample);
+  // Return the process table without refreshing it
+  const ProcessTable& Table() const;
+
  private:
+  // One step of Collect()
+  struct Step {
+    Collectors::Id collector;
+    void (System::*refresh)();
+  };
+  // One step of Capture()
+  using CaptureStep = void (System::*)(Sample& sample, std::size_t top);
+
+  Collectors::Set enabled_ = 0;
+  // What Enable() left of Collect() and Capture(), in order
+  std::vector<Step> steps_ = {};
+  std::vector<CaptureStep> captureSteps_ = {};
   Processor cpu_ = {};
-  std::vector<Process> processes_ = {};
+  LinuxParser::StatSnapshot stat_ = {};
+  // Commands and users of table_ and metadata_
+  StringArena strings_;
+  // Lives across refreshes so CPU utilization can be computed per interval.
+  // Also holds the processes Load() shows, so it is there in every build.
+  ProcessTable table_{strings_};
+#if MONITOR_COLLECT_PROCESSES || MONITOR_COLLECT_CGROUPS
+  WorkerPool pool_;
+#endif
+#if MONITOR_COLLECT_PROCESSES
+  // Pids of the current and the previous refresh
+  PidScanner scanner_;
+  // Which pids the refresh reads, and since when each was last read
+  SampleScheduler scheduler_;
+  // One slot per pid read, each written by exactly one worker. Reused
+  // across refreshes to keep the command buffers allocated.
+  std::vector<LinuxParser::ProcessSnapshot> snapshots_ = {};
+  std::vector<char> valid_ = {};
+  // Whether the slot holds metadata for metadata_
+  std::vector<char> described_ = {};
+  // Command, exe and user per (pid, starttime)
+  MetadataCache metadata_{strings_};
+#endif
+  SortColumn sortColumn_ = SortColumn::kCpu;
+  // (sort value, row of table_), reused across refreshes
+  std::vector<std::pair<double, std::uint32_t>> keys_ = {};
+  std::vector<ProcessTable::Row> top_ = {};
+  IoSelection ioSelection_ = {};
+#if MONITOR_COLLECT_IO
+  // Rows of table_ whose io file is read, and what it held
+  std::vector<std::uint32_t> ioRows_ = {};
+  std::vector<LinuxParser::IoCounters> ioReads_ = {};
+  std::vector<char> ioValid_ = {};
+#endif
+#if MONITOR_COLLECT_DEVICES
+  DeviceTable devices_;
+  // (bytes per second, position in the disks or interfaces of devices_),
+  // reused across captures
+  std::vector<std::pair<double, std::uint32_t>> deviceKeys_ = {};
+#endif
+  ThreadSelection threadSelection_ = {};
+#if MONITOR_COLLECT_THREADS
+  ThreadTable threads_;
+  // Processes read per thread, ascending
+  std::vector<int> threadPids_ = {};
+  // (CPU, position in threads_.Threads()), reused across captures
+  std::vector<std::pair<float, std::uint32_t>> threadKeys_ = {};
+#endif
+  bool showCgroups_ = false;
+  // Whether Processes() ran during the current Collect()
+  bool processesRead_ = false;
+#if MONITOR_COLLECT_CGROUPS
+  CgroupTable cgroups_;
+  // Pids of the cgroup table when Processes() did not run
+  PidScanner cgroupScanner_;
+  // Whether the last refresh used cgroupScanner_, so that its Added() and
+  // Removed() are what changed since
+  bool cgroupsScanned_ = false;
+  // Positions in the pids of the ones whose cgroup is read, their
+  // starttimes and what the cgroup was
+  std::vector<std::size_t> cgroupMisses_ = {};
+  std::vector<unsigned long long> cgroupStarttimes_ = {};
+  std::vector<std::string> cgroupPaths_ = {};
+  std::vector<char> cgroupValid_ = {};
+  // (sort value, position in cgroups_.Cgroups()), reused across captures
+  std::vector<std::pair<double, std::uint32_t>> cgroupKeys_ = {};
+#endif
+  std::string kernel_ = {};
+  std::string operatingSystem_ = {};
+
+  void FillKeys();
+  void RefreshProcesses();
+  void CaptureCpu(Sample& sample, std::size_t top);
+  void CaptureMemory(Sample& sample, std::size_t top);
+  void CaptureProcesses(Sample& sample, std::size_t top);
+#if MONITOR_COLLECT_DEVICES
+  void CaptureDevices(Sample& sample, std::size_t top);
+#endif
+#if MONITOR_COLLECT_THREADS
+  void CaptureThreads(Sample& sample, std::size_t top);
+#endif
+#if MONITOR_COLLECT_CGROUPS
+  void CaptureCgroups(Sample& sample, std::size_t top);
+#endif
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,64 @@
+#ifndef THREAD_TABLE_H
+#define THREAD_TABLE_H
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "linux_parser.h"
+#include "pid_scanner.h"
+#include "worker_pool.h"
+
+/*
+CPU utilization of single threads, to find the hot thread of a busy
+process. Only the processes passed to Refresh() are read per thread; there
+are far more threads than processes. The table is ordered by pid, then tid,
+so a single merge with the previous refresh finds each thread's previous
+jiffies without a hash lookup. A thread seen for the first time gets its
+lifetime average, like a new process.
+*/
+class ThreadTable {
+ public:
+  struct Thread {
+    int pid{0};
+    int tid{0};
+    unsigned long long starttime{0};
+    // utime + stime, in clock ticks
+    unsigned long activeJiffies{0};
+    float cpu{0};
+    std::string name;
+  };
+
+  // Read the threads of pids (ascending) on pool and drop the threads of
+  // every other process. uptime is the system uptime in seconds.
+  void Refresh(WorkerPool& pool, const std::vector<int>& pids, long uptime);
+  // Drop every thread
+  void Clear();
+  // Ordered by pid, then tid
+  const std::vector<Thread>& Threads() const;
+
+ private:
+  // The threads one worker read of one process
+  struct Slot {
+    std::vector<LinuxParser::TaskSnapshot> tasks;
+    std::size_t count{0};
+  };
+  // Per worker state, the task directory is different for every process
+  struct Reader {
+    PidScanner scanner;
+    std::string path;
+  };
+
+  std::vector<Slot> slots_;
+  std::unique_ptr<Reader[]> readers_;
+  std::size_t workers_{0};
+  std::vector<Thread> threads_;
+  // The table under construction, swapped with threads_ to keep the
+  // name buffers allocated
+  std::vector<Thread> next_;
+  std::chrono::steady_clock::time_point lastRefresh_;
+};
+
+#endif
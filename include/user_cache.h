@@ -0,0 +1,33 @@
+#ifndef USER_CACHE_H
+#define USER_CACHE_H
+
+#include <sys/types.h>
+#include <time.h>
+
+#include <string>
+#include <unordered_map>
+
+/*
+Maps uids to user names. The passwd file is parsed once and only parsed
+again when Refresh() sees that its inode, size or mtime changed. Uids that
+are not in the file (NSS, sssd, LDAP users) are resolved through
+getpwuid_r() once and cached as well, so Name() is a hash lookup.
+Not thread safe.
+*/
+class UserCache {
+ public:
+  void Refresh(const std::string& path);
+  const std::string& Name(int uid);
+
+ private:
+  void Load();
+
+  std::string path_;
+  dev_t device_{0};
+  ino_t inode_{0};
+  off_t size_{-1};
+  timespec mtime_{};
+  std::unordered_map<int, std::string> names_;
+};
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+Fixed set of threads for data parallel loops. ParallelFor() splits the index
+range evenly across the workers, and a worker that runs dry steals the back
+half of another worker's remaining range, so a few slow items (e.g. a
+process in D state) do not hold up everybody else. The calling thread takes
+part as worker 0.
+*/
+class WorkerPool {
+ public:
+  // Task arguments are the index and the worker running it, < Size()
+  using Task = std::function<void(std::size_t index, std::size_t worker)>;
+
+  // threads == 0 uses one thread per hardware thread
+  explicit WorkerPool(std::size_t threads = 0);
+  ~WorkerPool();
+  WorkerPool(const WorkerPool&) = delete;
+  WorkerPool& operator=(const WorkerPool&) = delete;
+
+  std::size_t Size() const;
+  // Run task for every index in [0, count) and return when all are done
+  void ParallelFor(std::size_t count, const Task& task);
+
+ private:
+  // Remaining range of one worker, packed as begin | end << 32 so owner and
+  // thieves can both shrink it with a single compare and swap.
+  struct alignas(64) Range {
+    std::atomic<std::uint64_t> bounds{0};
+  };
+
+  void Loop(std::size_t worker);
+  void Work(std::size_t worker);
+  bool Next(std::size_t worker, std::size_t& index);
+  bool Steal(std::size_t worker);
+
+  std::vector<std::thread> threads_;
+  std::unique_ptr<Range[]> ranges_;
+  std::size_t size_;
+
+  std::mutex mutex_;
+  std::condition_variable start_;
+  std::condition_variable done_;
+  const Task* task_{nullptr};
+  std::uint64_t generation_{0};
+  std::size_t running_{0};
+  bool stop_{false};
+};
+
+#endif
@@ -0,0 +1,416 @@
+#include "batch.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+
+#include "options.h"
+#include "sample_loop.h"
+
+namespace {
+// Write all of buffer to fd, retrying short writes
+bool writeAll(int fd, const char* buffer, std::size_t size) {
+  while (size > 0) {
+    ssize_t written = write(fd, buffer, size);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    buffer += written;
+    size -= written;
+  }
+  return true;
+}
+}  // namespace
+
+bool Batch::ParseFormat(const std::string& name, Format& format) {
+  if (name == "json") {
+    format = Format::kJson;
+  } else if (name == "csv") {
+    format = Format::kCsv;
+  } else if (name == "binary") {
+    format = Format::kBinary;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+Batch::Writer::Writer(Format format, int fd) : format_(format), fd_(fd) {}
+
+bool Batch::Writer::Write(const Sample& sample) {
+  buffer_.clear();
+  switch (format_) {
+    case Format::kJson:
+      Json(sample);
+      break;
+    case Format::kCsv:
+      Csv(sample);
+      break;
+    case Format::kBinary:
+      Binary(sample);
+      break;
+  }
+  return writeAll(fd_, buffer_.data(), buffer_.size());
+}
+
+const std::string& Batch::Writer::Buffer() const { return buffer_; }
+
+void Batch::Writer::Json(const Sample& sample) {
+  Append("{\"tick\":");
+  Number(sample.tick);
+  Append(",\"timestamp\":");
+  Number(sample.timestamp);
+  Append(",\"cpu\":");
+  Percent(sample.cpu);
+  Append(",\"steal\":");
+  Percent(sample.steal);
+  Append(",\"memory\":");
+  Percent(sample.memory);
+  Append(",\"uptime\":");
+  Number(sample.uptime);
+  Append(",\"processes_total\":");
+  Number(sample.totalProcesses);
+  Append(",\"processes_running\":");
+  Number(sample.runningProcesses);
+  Append(",\"ctxt\":");
+  Number(sample.contextSwitches);
+  Append(",\"intr\":");
+  Number(sample.interrupts);
+  Append(",\"cores\":[");
+  for (std::size_t i = 0; i < sample.cores.size(); ++i) {
+    if (i > 0) {
+      Append(',');
+    }
+    Percent(sample.cores[i]);
+  }
+  Append("],\"processes\":[");
+  for (std::size_t i = 0; i < sample.processes.size(); ++i) {
+    const Process& process = sample.processes[i];
+    Append(i > 0 ? ",{\"pid\":" : "{\"pid\":");
+    Number(process.Pid());
+    Append(",\"user\":");
+    JsonString(process.User());
+    Append(",\"cpu\":");
+    Percent(process.CpuUtilization());
+    Append(",\"ram_mb\":");
+    Number(process.RamMb());
+    Append(",\"uptime\":");
+    Number(process.UpTime());
+    Append(",\"read_bps\":");
+    Number(std::uint64_t(process.ReadRate()));
+    Append(",\"write_bps\":");
+    Number(std::uint64_t(process.WriteRate()));
+    JsonCommand(process.Command());
+    Append('}');
+  }
+  Append("],\"disks\":[");
+  for (std::size_t i = 0; i < sample.disks.size(); ++i) {
+    const DiskSample& disk = sample.disks[i];
+    Append(i > 0 ? ",{\"name\":" : "{\"name\":");
+    JsonString(disk.name);
+    Append(",\"read_bps\":");
+    Number(std::uint64_t(disk.readRate));
+    Append(",\"write_bps\":");
+    Number(std::uint64_t(disk.writeRate));
+    Append(",\"iops\":");
+    Number(std::uint64_t(disk.iops));
+    Append(",\"utilization\":");
+    Percent(disk.utilization);
+    Append('}');
+  }
+  Append("],\"net\":[");
+  for (std::size_t i = 0; i < sample.interfaces.size(); ++i) {
+    const InterfaceSample& interface = sample.interfaces[i];
+    Append(i > 0 ? ",{\"name\":" : "{\"name\":");
+    JsonString(interface.name);
+    Append(",\"rx_bps\":");
+    Number(std::uint64_t(interface.receiveRate));
+    Append(",\"tx_bps\":");
+    Number(std::uint64_t(interface.transmitRate));
+    Append('}');
+  }
+  Append("]}\n");
+}
+
+void Batch::Writer::Csv(const Sample& sample) {
+  if (!header_) {
+    Append(
+        "tick,timestamp,cpu,memory,uptime,processes_total,processes_running,"
+        "pid,user,process_cpu,ram_mb,process_uptime,read_bps,write_bps,"
+        "command\n");
+    header_ = true;
+  }
+  for (const Process& process : sample.processes) {
+    Number(sample.tick);
+    Append(',');
+    Number(sample.timestamp);
+    Append(',');
+    Percent(sample.cpu);
+    Append(',');
+    Percent(sample.memory);
+    Append(',');
+    Number(sample.uptime);
+    Append(',');
+    Number(sample.totalProcesses);
+    Append(',');
+    Number(sample.runningProcesses);
+    Append(',');
+    Number(process.Pid());
+    Append(',');
+    CsvString(process.User());
+    Append(',');
+    Percent(process.CpuUtilization());
+    Append(',');
+    Number(process.RamMb());
+    Append(',');
+    Number(process.UpTime());
+    Append(',');
+    Number(std::uint64_t(process.ReadRate()));
+    Append(',');
+    Number(std::uint64_t(process.WriteRate()));
+    Append(',');
+    CsvString(process.Command());
+    Append('\n');
+  }
+}
+
+// Record layout, all values in native byte order:
+//   u32 length of the rest of the record
+//   u64 tick, i64 timestamp, f32 cpu, f32 steal, f32 memory, i64 uptime,
+//   i32 processes_total, i32 processes_running, u64 ctxt, u64 intr,
+//   u32 cores, f32 per core,
+//   u32 processes, per process: i32 pid, f32 cpu, i64 ram_mb, i64 uptime,
+//   f32 read bytes/s, f32 write bytes/s, u16 length + user bytes,
+//   u16 length + command bytes, its arguments separated by NUL
+void Batch::Writer::Binary(const Sample& sample) {
+  Raw<std::uint32_t>(0);
+  Raw<std::uint64_t>(sample.tick);
+  Raw<std::int64_t>(sample.timestamp);
+  Raw<float>(sample.cpu);
+  Raw<float>(sample.steal);
+  Raw<float>(sample.memory);
+  Raw<std::int64_t>(sample.uptime);
+  Raw<std::int32_t>(sample.totalProcesses);
+  Raw<std::int32_t>(sample.runningProcesses);
+  Raw<std::uint64_t>(sample.contextSwitches);
+  Raw<std::uint64_t>(sample.interrupts);
+  Raw<std::uint32_t>(sample.cores.size());
+  for (float core : sample.cores) {
+    Raw<float>(core);
+  }
+  Raw<std::uint32_t>(sample.processes.size());
+  for (const Process& process : sample.processes) {
+    Raw<std::int32_t>(process.Pid());
+    Raw<float>(process.CpuUtilization());
+    Raw<std::int64_t>(process.RamMb());
+    Raw<std::int64_t>(process.UpTime());
+    Raw<float>(process.ReadRate());
+    Raw<float>(process.WriteRate());
+    RawString(process.User());
+    RawString(process.Command());
+  }
+  const std::uint32_t length = buffer_.size() - sizeof(std::uint32_t);
+  std::memcpy(&buffer_[0], &length, sizeof(length));
+}
+
+void Batch::Writer::Append(const char* text) { buffer_.append(text); }
+
+void Batch::Writer::Append(char c) { buffer_.push_back(c); }
+
+template <typename TValue>
+void Batch::Writer::Number(TValue value) {
+  char digits[24];
+  auto result = std::to_chars(digits, digits + sizeof(digits), value);
+  buffer_.append(digits, result.ptr);
+}
+
+// Shares (0..1) are written with four decimals
+void Batch::Writer::Percent(float share) {
+  char digits[32];
+  auto result = std::to_chars(digits, digits + sizeof(digits), share,
+                              std::chars_format::fixed, 4);
+  buffer_.append(digits, result.ptr);
+}
+
+void Batch::Writer::JsonString(std::string_view text) {
+  buffer_.push_back('"');
+  JsonCharacters(text);
+  buffer_.push_back('"');
+}
+
+void Batch::Writer::JsonCharacters(std::string_view text) {
+  for (char c : text) {
+    switch (c) {
+      case '"':
+        buffer_.append("\\\"");
+        break;
+      case '\\':
+        buffer_.append("\\\\");
+        break;
+      case '\n':
+        buffer_.append("\\n");
+        break;
+      case '\t':
+        buffer_.append("\\t");
+        break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          char escaped[8];
+          std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+          buffer_.append(escaped);
+        } else {
+          buffer_.push_back(c);
+        }
+    }
+  }
+}
+
+// The command as shown, arguments joined by spaces, then as the argv array
+// that keeps them apart
+void Batch::Writer::JsonCommand(const std::string& command) {
+  Append(",\"command\":\"");
+  std::string_view rest{command};
+  while (true) {
+    const std::size_t end = rest.find('\0');
+    JsonCharacters(rest.substr(0, end));
+    if (end == std::string_view::npos) {
+      break;
+    }
+    buffer_.push_back(' ');
+    rest.remove_prefix(end + 1);
+  }
+  Append("\",\"argv\":[");
+  // No arguments at all for an empty command
+  rest = command;
+  while (!command.empty()) {
+    const std::size_t end = rest.find('\0');
+    JsonString(rest.substr(0, end));
+    if (end == std::string_view::npos) {
+      break;
+    }
+    buffer_.push_back(',');
+    rest.remove_prefix(end + 1);
+  }
+  buffer_.push_back(']');
+}
+
+// Quote fields containing separators, quotes or line breaks (RFC 4180). The
+// NULs between the arguments of a command become spaces.
+void Batch::Writer::CsvString(const std::string& text) {
+  const std::string_view special(",\"\r\n\0", 5);
+  if (text.find_first_of(special) == std::string::npos) {
+    buffer_.append(text);
+    return;
+  }
+  const bool quote = text.find_first_of(special.substr(0, 4)) !=
+                     std::string::npos;
+  if (quote) {
+    buffer_.push_back('"');
+  }
+  for (char c : text) {
+    if (c == '"') {
+      buffer_.push_back('"');
+    }
+    buffer_.push_back(c == '\0' ? ' ' : c);
+  }
+  if (quote) {
+    buffer_.push_back('"');
+  }
+}
+
+template <typename TValue>
+void Batch::Writer::Raw(TValue value) {
+  buffer_.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void Batch::Writer::RawString(const std::string& text) {
+  const std::uint16_t length = std::min<std::size_t>(text.size(), 0xffff);
+  Raw<std::uint16_t>(length);
+  buffer_.append(text.data(), length);
+}
+
+namespace {
+// Return the output descriptor options ask for, -1 on failure
+int openOutput(const Options& options) {
+  if (options.output.empty()) {
+    return STDOUT_FILENO;
+  }
+  int fd = open(options.output.c_str(),
+                O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    std::perror(options.output.c_str());
+  }
+  return fd;
+}
+}  // namespace
+
+int Batch::Run(System& system, const Options& options,
+               Recording::Writer* recorder) {
+  int fd = openOutput(options);
+  if (fd < 0) {
+    return 1;
+  }
+
+  Writer writer(options.format, fd);
+  int status = 0;
+  // A closed pipe ends the run through the failing write.
+  SampleLoop::Run(system, options, options.iterations, recorder,
+                  [&](const Sample& sample) {
+                    if (writer.Write(sample)) {
+                      return true;
+                    }
+                    if (errno != EPIPE) {
+                      std::perror("write");
+                      status = 1;
+                    }
+                    return false;
+                  });
+  if (fd != STDOUT_FILENO) {
+    close(fd);
+  }
+  return status;
+}
+
+int Batch::Dump(const Options& options) {
+  Recording::Reader reader;
+  std::string error;
+  if (!reader.Open(options.dump, error)) {
+    std::fprintf(stderr, "%s\n", error.c_str());
+    return 1;
+  }
+  int fd = openOutput(options);
+  if (fd < 0) {
+    return 1;
+  }
+
+  signal(SIGPIPE, SIG_IGN);
+  Writer writer(options.format, fd);
+  Sample sample;
+  int status = 0;
+  const std::uint64_t records = reader.Records();
+  const std::uint64_t first =
+      records > reader.Slots() ? records - reader.Slots() : 0;
+  for (std::uint64_t record = first; record < records; ++record) {
+    // Skip records torn by a crash or overwritten since Records()
+    if (reader.Read(record, sample) && !writer.Write(sample)) {
+      if (errno != EPIPE) {
+        std::perror("write");
+        status = 1;
+      }
+      break;
+    }
+  }
+  if (fd != STDOUT_FILENO) {
+    close(fd);
+  }
+  return status;
+}
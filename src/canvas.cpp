@@ -0,0 +1,108 @@
+#include "canvas.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+// Unchanged cells between two changed runs that are sent along anyway,
+// cheaper than positioning the cursor again
+int const run_gap{4};
+
+// Control bytes would go to the terminal unfiltered, where a process name
+// like "\x1b[2J" becomes an escape sequence. Show them as '?'.
+chtype printable(char c) {
+  const unsigned char byte = c;
+  return byte < 0x20 || byte == 0x7f ? '?' : byte;
+}
+}  // namespace
+
+// Takes ownership of window
+Canvas::Canvas(WINDOW* window)
+    : window_(window),
+      rows_(getmaxy(window)),
+      columns_(getmaxx(window)),
+      cells_(rows_ * columns_, ' '),
+      // Differs from every cell, the first Flush() sends everything
+      previous_(rows_ * columns_, 0) {}
+
+Canvas::~Canvas() { delwin(window_); }
+
+int Canvas::Rows() const { return rows_; }
+
+int Canvas::Columns() const { return columns_; }
+
+void Canvas::Clear() { std::fill(cells_.begin(), cells_.end(), ' '); }
+
+void Canvas::Invalidate() { std::fill(previous_.begin(), previous_.end(), 0); }
+
+void Canvas::Box() {
+  chtype* top = &cells_[0];
+  chtype* bottom = &cells_[(rows_ - 1) * columns_];
+  std::fill(top + 1, top + columns_ - 1, ACS_HLINE);
+  std::fill(bottom + 1, bottom + columns_ - 1, ACS_HLINE);
+  for (int row = 1; row < rows_ - 1; ++row) {
+    cells_[row * columns_] = ACS_VLINE;
+    cells_[row * columns_ + columns_ - 1] = ACS_VLINE;
+  }
+  top[0] = ACS_ULCORNER;
+  top[columns_ - 1] = ACS_URCORNER;
+  bottom[0] = ACS_LLCORNER;
+  bottom[columns_ - 1] = ACS_LRCORNER;
+}
+
+int Canvas::Put(int row, int column, std::string_view text,
+                chtype attributes) {
+  if (row < 0 || row >= rows_ || column < 0) {
+    return column;
+  }
+  const int end =
+      std::min<int>(column + text.size(), std::max(column, columns_ - 1));
+  chtype* cell = &cells_[row * columns_];
+  for (int i = column; i < end; ++i) {
+    cell[i] = printable(text[i - column]) | attributes;
+  }
+  return end;
+}
+
+int Canvas::Put(int row, int column, chtype c) {
+  if (row < 0 || row >= rows_ || column < 0 || column >= columns_ - 1) {
+    return column;
+  }
+  cells_[row * columns_ + column] = c;
+  return column + 1;
+}
+
+std::size_t Canvas::Flush() {
+  std::size_t sent = 0;
+  for (int row = 0; row < rows_; ++row) {
+    const chtype* cells = &cells_[row * columns_];
+    const chtype* previous = &previous_[row * columns_];
+    // Most rows do not change at all
+    if (std::memcmp(cells, previous, columns_ * sizeof(chtype)) == 0) {
+      continue;
+    }
+    int column = 0;
+    while (column < columns_) {
+      if (cells[column] == previous[column]) {
+        ++column;
+        continue;
+      }
+      // Extend the run over changed cells and short unchanged gaps
+      const int start = column;
+      int end = column + 1;
+      for (int next = end; next < columns_ && next - end < run_gap; ++next) {
+        if (cells[next] != previous[next]) {
+          end = next + 1;
+        }
+      }
+      mvwaddchnstr(window_, row, start, cells + start, end - start);
+      sent += end - start;
+      column = end;
+    }
+  }
+  if (sent > 0) {
+    wnoutrefresh(window_);
+  }
+  previous_.swap(cells_);
+  return sent;
+}
@@ -0,0 +1,103 @@
+#include "cgroup_table.h"
+
+#include <algorithm>
+#include <utility>
+
+bool CgroupTable::Known(int pid, unsigned long long starttime) const {
+  auto found = members_.find(pid);
+  return found != members_.end() && found->second.starttime == starttime;
+}
+
+bool CgroupTable::Mapped(int pid) const { return members_.count(pid) != 0; }
+
+void CgroupTable::Map(int pid, unsigned long long starttime,
+                      const std::string& path) {
+  auto cgroup = index_.find(path);
+  if (cgroup == index_.end()) {
+    cgroup = index_.emplace(path, cgroups_.size()).first;
+    cgroups_.emplace_back();
+    cgroups_.back().path = path;
+  }
+  members_[pid] = {starttime, cgroup->second};
+}
+
+void CgroupTable::Forget(int pid) { members_.erase(pid); }
+
+void CgroupTable::Retain(const std::vector<int>& pids) {
+  for (auto member = members_.begin(); member != members_.end();) {
+    if (std::binary_search(pids.begin(), pids.end(), member->first)) {
+      ++member;
+    } else {
+      member = members_.erase(member);
+    }
+  }
+}
+
+void CgroupTable::Refresh() {
+  const auto now = std::chrono::steady_clock::now();
+  const double elapsed =
+      lastRefresh_ == std::chrono::steady_clock::time_point{}
+          ? 0
+          : std::chrono::duration<double>(now - lastRefresh_).count();
+  lastRefresh_ = now;
+
+  for (Cgroup& cgroup : cgroups_) {
+    cgroup.processes = 0;
+  }
+  for (const auto& member : members_) {
+    ++cgroups_[member.second.cgroup].processes;
+  }
+
+  // Keep the cgroups with processes in place, remapping the members only
+  // when one was dropped
+  moved_.resize(cgroups_.size());
+  std::size_t kept = 0;
+  for (std::size_t i = 0; i < cgroups_.size(); ++i) {
+    if (cgroups_[i].processes == 0) {
+      index_.erase(cgroups_[i].path);
+      continue;
+    }
+    if (kept != i) {
+      cgroups_[kept] = std::move(cgroups_[i]);
+      index_[cgroups_[kept].path] = kept;
+    }
+    moved_[i] = kept++;
+  }
+  if (kept != cgroups_.size()) {
+    cgroups_.resize(kept);
+    for (auto& member : members_) {
+      member.second.cgroup = moved_[member.second.cgroup];
+    }
+  }
+
+  for (Cgroup& cgroup : cgroups_) {
+    const LinuxParser::CgroupCounters previous = cgroup.counters;
+    const bool read =
+        LinuxParser::ReadCgroupCounters(cgroup.path, cgroup.counters);
+    // A new cgroup has no previous counters yet
+    if (!read || previous.usageUsec == 0 || elapsed <= 0) {
+      cgroup.cpu = 0;
+      cgroup.readRate = 0;
+      cgroup.writeRate = 0;
+      continue;
+    }
+    // Counters only grow, unless the cgroup was removed and created again
+    auto rate = [elapsed](unsigned long long now, unsigned long long then) {
+      return now >= then ? (now - then) / elapsed : 0.0;
+    };
+    cgroup.cpu = rate(cgroup.counters.usageUsec, previous.usageUsec) / 1e6;
+    cgroup.readRate = rate(cgroup.counters.readBytes, previous.readBytes);
+    cgroup.writeRate = rate(cgroup.counters.writeBytes, previous.writeBytes);
+  }
+}
+
+void CgroupTable::Clear() {
+  members_.clear();
+  cgroups_.clear();
+  index_.clear();
+  lastRefresh_ = {};
+}
+
+const std::vector<CgroupTable::Cgroup>& CgroupTable::Cgroups() const {
+  return cgroups_;
+}
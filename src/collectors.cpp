@@ -0,0 +1,50 @@
+#include "collectors.h"
+
+#include <string_view>
+
+namespace {
+const char* const names[] = {"cpu",     "memory",  "processes", "io",
+                             "threads", "cgroups", "devices"};
+static_assert(sizeof(names) / sizeof(names[0]) ==
+                  static_cast<std::size_t>(Collectors::Id::kCount),
+              "one name per collector");
+}  // namespace
+
+const char* Collectors::Name(Id id) {
+  return names[static_cast<std::size_t>(id)];
+}
+
+bool Collectors::Parse(const std::string& list, Set& set, std::string& error) {
+  set = 0;
+  std::string_view rest{list};
+  while (true) {
+    const std::size_t comma = rest.find(',');
+    const std::string_view name = rest.substr(0, comma);
+    int found = -1;
+    for (int id = 0; id < static_cast<int>(Id::kCount); ++id) {
+      if (name == names[id]) {
+        found = id;
+      }
+    }
+    if (found < 0) {
+      error = "unknown collector " + std::string(name);
+      return false;
+    }
+    if (!Built(static_cast<Id>(found))) {
+      error = "collector " + std::string(name) + " was left out of the build";
+      return false;
+    }
+    set |= Bit(static_cast<Id>(found));
+    if (comma == std::string_view::npos) {
+      return true;
+    }
+    rest.remove_prefix(comma + 1);
+  }
+}
+
+Collectors::Set Collectors::WithDependencies(Set set) {
+  if (set & (Bit(Id::kIo) | Bit(Id::kThreads))) {
+    set |= Bit(Id::kProcesses);
+  }
+  return set;
+}
@@ -0,0 +1,137 @@
+#include "device_table.h"
+
+#include <algorithm>
+#include <cctype>
+#include <string_view>
+#include <utility>
+
+namespace {
+// Whether name is a partition of disk: sda1 of sda, nvme0n1p1 of nvme0n1.
+// Without the p a disk name ending in a digit would make loop10 a partition
+// of loop1.
+bool partitionOf(std::string_view name, std::string_view disk) {
+  if (name.size() <= disk.size() || name.substr(0, disk.size()) != disk) {
+    return false;
+  }
+  std::string_view suffix = name.substr(disk.size());
+  if (std::isdigit(static_cast<unsigned char>(disk.back()))) {
+    if (suffix.front() != 'p') {
+      return false;
+    }
+    suffix.remove_prefix(1);
+  }
+  return !suffix.empty() &&
+         std::all_of(suffix.begin(), suffix.end(), [](char c) {
+           return std::isdigit(static_cast<unsigned char>(c));
+         });
+}
+
+// Position of the entry called name in previous, guessing it did not move
+template <typename TEntry>
+std::size_t find(const std::vector<TEntry>& previous, std::size_t guess,
+                 const std::string& name) {
+  if (guess < previous.size() && previous[guess].name == name) {
+    return guess;
+  }
+  for (std::size_t i = 0; i < previous.size(); ++i) {
+    if (previous[i].name == name) {
+      return i;
+    }
+  }
+  return previous.size();
+}
+
+// Counters only grow, unless the device was removed and added again
+double rate(unsigned long long now, unsigned long long then, double elapsed) {
+  return now >= then ? (now - then) / elapsed : 0.0;
+}
+}  // namespace
+
+void DeviceTable::Refresh() {
+  const auto now = std::chrono::steady_clock::now();
+  const double elapsed =
+      lastRefresh_ == std::chrono::steady_clock::time_point{}
+          ? 0
+          : std::chrono::duration<double>(now - lastRefresh_).count();
+  lastRefresh_ = now;
+  RefreshDisks(elapsed);
+  RefreshInterfaces(elapsed);
+}
+
+const std::vector<DeviceTable::Disk>& DeviceTable::Disks() const {
+  return disks_;
+}
+
+const std::vector<DeviceTable::Interface>& DeviceTable::Interfaces() const {
+  return interfaces_;
+}
+
+void DeviceTable::RefreshDisks(double elapsed) {
+  LinuxParser::ReadDiskStats(diskReads_);
+  const bool same = names_.size() == diskReads_.size() &&
+                    std::equal(names_.begin(), names_.end(),
+                               diskReads_.begin(),
+                               [](const std::string& name,
+                                  const LinuxParser::DiskCounters& disk) {
+                                 return name == disk.name;
+                               });
+  if (!same) {
+    names_.resize(diskReads_.size());
+    whole_.assign(diskReads_.size(), true);
+    for (std::size_t i = 0; i < diskReads_.size(); ++i) {
+      names_[i] = diskReads_[i].name;
+    }
+    for (std::size_t i = 0; i < names_.size(); ++i) {
+      for (std::size_t j = 0; j < names_.size() && whole_[i]; ++j) {
+        whole_[i] = !partitionOf(names_[i], names_[j]);
+      }
+    }
+  }
+
+  nextDisks_.clear();
+  for (std::size_t i = 0; i < diskReads_.size(); ++i) {
+    const LinuxParser::DiskCounters& read = diskReads_[i];
+    if (!whole_[i] || read.reads + read.writes == 0) {
+      continue;
+    }
+    nextDisks_.emplace_back();
+    Disk& disk = nextDisks_.back();
+    disk.name = read.name;
+    disk.counters = read;
+    const std::size_t previous = find(disks_, nextDisks_.size() - 1, read.name);
+    if (previous == disks_.size() || elapsed <= 0) {
+      continue;
+    }
+    const LinuxParser::DiskCounters& then = disks_[previous].counters;
+    disk.readRate = rate(read.readSectors, then.readSectors, elapsed) * 512;
+    disk.writeRate =
+        rate(read.writeSectors, then.writeSectors, elapsed) * 512;
+    disk.iops = rate(read.reads + read.writes, then.reads + then.writes,
+                     elapsed);
+    disk.utilization = std::min(
+        1.0, rate(read.busyMs, then.busyMs, elapsed) / 1000);
+  }
+  std::swap(disks_, nextDisks_);
+}
+
+void DeviceTable::RefreshInterfaces(double elapsed) {
+  LinuxParser::ReadNetDev(interfaceReads_);
+  nextInterfaces_.clear();
+  for (const LinuxParser::NetCounters& read : interfaceReads_) {
+    nextInterfaces_.emplace_back();
+    Interface& interface = nextInterfaces_.back();
+    interface.name = read.name;
+    interface.counters = read;
+    const std::size_t previous =
+        find(interfaces_, nextInterfaces_.size() - 1, read.name);
+    if (previous == interfaces_.size() || elapsed <= 0) {
+      continue;
+    }
+    const LinuxParser::NetCounters& then = interfaces_[previous].counters;
+    interface.receiveRate =
+        rate(read.receiveBytes, then.receiveBytes, elapsed);
+    interface.transmitRate =
+        rate(read.transmitBytes, then.transmitBytes, elapsed);
+  }
+  std::swap(interfaces_, nextInterfaces_);
+}
@@ -0,0 +1,719 @@
+#include "exporter.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/timerfd.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string_view>
+
+#include "options.h"
+#include "sample_loop.h"
+
+namespace {
+std::string systemError(const std::string& what) {
+  return what + ": " + std::strerror(errno);
+}
+
+// Scrapers are few, this is far above what they need
+constexpr std::size_t kMaxConnections{64};
+// A connection that neither sends a whole request nor takes its response
+// for this long is closed...
+constexpr std::chrono::seconds kStallTimeout{10};
+// ...and one with nothing to do is kept for scrapes this far apart
+constexpr std::chrono::seconds kIdleTimeout{120};
+
+// Longest request header accepted, scrapers send a few hundred bytes
+constexpr std::size_t kMaxRequest{8192};
+
+template <typename TValue>
+void number(std::string& body, TValue value) {
+  char digits[24];
+  auto result = std::to_chars(digits, digits + sizeof(digits), value);
+  body.append(digits, result.ptr);
+}
+
+// Shares (0..1) are written with four decimals, like the batch records
+void share(std::string& body, float value) {
+  char digits[32];
+  auto result = std::to_chars(digits, digits + sizeof(digits), value,
+                              std::chars_format::fixed, 4);
+  body.append(digits, result.ptr);
+}
+
+// Length of the UTF-8 sequence starting text[0], 0 if it is not valid:
+// overlong forms, surrogates and code points past U+10FFFF are rejected
+std::size_t utf8Length(std::string_view text) {
+  const auto byte = [&text](std::size_t i) {
+    return static_cast<unsigned char>(text[i]);
+  };
+  const unsigned char lead = byte(0);
+  if (lead < 0x80) {
+    return 1;
+  }
+  std::size_t length;
+  unsigned char low = 0x80;
+  unsigned char high = 0xbf;
+  if (lead >= 0xc2 && lead <= 0xdf) {
+    length = 2;
+  } else if (lead >= 0xe0 && lead <= 0xef) {
+    length = 3;
+    low = lead == 0xe0 ? 0xa0 : 0x80;
+    high = lead == 0xed ? 0x9f : 0xbf;
+  } else if (lead >= 0xf0 && lead <= 0xf4) {
+    length = 4;
+    low = lead == 0xf0 ? 0x90 : 0x80;
+    high = lead == 0xf4 ? 0x8f : 0xbf;
+  } else {
+    return 0;
+  }
+  if (text.size() < length || byte(1) < low || byte(1) > high) {
+    return 0;
+  }
+  for (std::size_t i = 2; i < length; ++i) {
+    if (byte(i) < 0x80 || byte(i) > 0xbf) {
+      return 0;
+    }
+  }
+  return length;
+}
+
+// A label value, escaped as the text format requires. Label values must be
+// UTF-8, command lines need not be: invalid bytes become U+FFFD. The NULs
+// between the arguments of a command become spaces.
+void label(std::string& body, const char* name, std::string_view value) {
+  body.append(name);
+  body.append("=\"");
+  while (!value.empty()) {
+    const std::size_t length = utf8Length(value);
+    if (length == 0) {
+      body.append("\xef\xbf\xbd");
+      value.remove_prefix(1);
+      continue;
+    }
+    switch (value.front()) {
+      case '"':
+        body.append("\\\"");
+        break;
+      case '\\':
+        body.append("\\\\");
+        break;
+      case '\n':
+        body.append("\\n");
+        break;
+      case '\0':
+        body.push_back(' ');
+        break;
+      default:
+        body.append(value.data(), length);
+    }
+    value.remove_prefix(length);
+  }
+  body.push_back('"');
+}
+
+// The metadata lines of a metric family. unit may be null; if given, name
+// ends in it.
+void family(std::string& body, const char* name, const char* type,
+            const char* unit, const char* help) {
+  body.append("# TYPE ").append(name).append(" ").append(type).append("\n");
+  if (unit != nullptr) {
+    body.append("# UNIT ").append(name).append(" ").append(unit);
+    body.push_back('\n');
+  }
+  body.append("# HELP ").append(name).append(" ").append(help).append("\n");
+}
+
+// The start of a per process sample, up to the value
+void processSample(std::string& body, const char* name,
+                   const Process& process) {
+  body.append(name);
+  body.append("{pid=\"");
+  number(body, process.Pid());
+  body.append("\",");
+  label(body, "user", process.User());
+  body.push_back(',');
+  label(body, "command", process.Command());
+  body.append("} ");
+}
+
+// The start of a per device sample, up to the value
+void deviceSample(std::string& body, const char* name, const char* key,
+                  const std::string& device) {
+  body.append(name);
+  body.push_back('{');
+  label(body, key, device);
+  body.append("} ");
+}
+
+using Response = Exporter::Server::Response;
+
+std::shared_ptr<const Response> fixedResponse(const char* status) {
+  auto response = std::make_shared<Response>();
+  response->body = std::string(status) + "\n";
+  response->header = std::string("HTTP/1.1 ") + status +
+                     "\r\nContent-Type: text/plain; charset=utf-8"
+                     "\r\nContent-Length: " +
+                     std::to_string(response->body.size()) + "\r\n\r\n";
+  return response;
+}
+
+// Whether the header block asks to close the connection after the response
+bool closeRequested(std::string_view request, std::string_view version) {
+  std::string lower(request);
+  std::transform(lower.begin(), lower.end(), lower.begin(), [](char c) {
+    return std::tolower(static_cast<unsigned char>(c));
+  });
+  if (version == "HTTP/1.0") {
+    return lower.find("\r\nconnection: keep-alive") == std::string::npos;
+  }
+  return lower.find("\r\nconnection: close") != std::string::npos;
+}
+}  // namespace
+
+bool Exporter::ParseAddress(const std::string& text, Address& address) {
+  std::string_view port{text};
+  constexpr std::string_view loopback{"127.0.0.1:"};
+  if (port.substr(0, loopback.size()) == loopback) {
+    port.remove_prefix(loopback.size());
+  }
+  int parsed{0};
+  auto [last, error] =
+      std::from_chars(port.data(), port.data() + port.size(), parsed);
+  if (!port.empty() && error == std::errc() &&
+      last == port.data() + port.size()) {
+    if (parsed < 1 || parsed > 65535) {
+      return false;
+    }
+    address.path.clear();
+    address.port = parsed;
+    return true;
+  }
+  if (text.empty() || text.size() >= sizeof(sockaddr_un::sun_path)) {
+    return false;
+  }
+  address.path = text;
+  address.port = 0;
+  return true;
+}
+
+void Exporter::Render(const Sample& sample, Collectors::Set enabled,
+                      std::string& body) {
+  using Collectors::Bit;
+  using Collectors::Id;
+  if (enabled & Bit(Id::kCpu)) {
+    family(body, "monitor_cpu_utilization_ratio", "gauge", "ratio",
+           "Share of CPU time spent busy over the last interval.");
+    body.append("monitor_cpu_utilization_ratio ");
+    share(body, sample.cpu);
+    body.push_back('\n');
+    family(body, "monitor_cpu_steal_ratio", "gauge", "ratio",
+           "Share of CPU time stolen by the hypervisor over the last "
+           "interval.");
+    body.append("monitor_cpu_steal_ratio ");
+    share(body, sample.steal);
+    body.push_back('\n');
+    family(body, "monitor_core_utilization_ratio", "gauge", "ratio",
+           "Share of CPU time spent busy per core over the last interval.");
+    for (std::size_t core = 0; core < sample.cores.size(); ++core) {
+      body.append("monitor_core_utilization_ratio{core=\"");
+      number(body, core);
+      body.append("\"} ");
+      share(body, sample.cores[core]);
+      body.push_back('\n');
+    }
+    family(body, "monitor_processes_created", "counter", nullptr,
+           "Processes and threads created since boot.");
+    body.append("monitor_processes_created_total ");
+    number(body, sample.totalProcesses);
+    body.push_back('\n');
+    family(body, "monitor_processes_running", "gauge", nullptr,
+           "Processes and threads runnable.");
+    body.append("monitor_processes_running ");
+    number(body, sample.runningProcesses);
+    body.push_back('\n');
+    family(body, "monitor_context_switches", "counter", nullptr,
+           "Context switches since boot.");
+    body.append("monitor_context_switches_total ");
+    number(body, sample.contextSwitches);
+    body.push_back('\n');
+    family(body, "monitor_interrupts", "counter", nullptr,
+           "Interrupts serviced since boot.");
+    body.append("monitor_interrupts_total ");
+    number(body, sample.interrupts);
+    body.push_back('\n');
+  }
+  if (enabled & Bit(Id::kMemory)) {
+    family(body, "monitor_memory_utilization_ratio", "gauge", "ratio",
+           "Share of memory in use.");
+    body.append("monitor_memory_utilization_ratio ");
+    share(body, sample.memory);
+    body.push_back('\n');
+  }
+  family(body, "monitor_uptime_seconds", "gauge", "seconds",
+         "Time since boot.");
+  body.append("monitor_uptime_seconds ");
+  number(body, sample.uptime);
+  body.push_back('\n');
+
+  if (enabled & Bit(Id::kProcesses)) {
+    family(body, "monitor_process_cpu_utilization_ratio", "gauge", "ratio",
+           "Share of one CPU used by a top process over the last interval.");
+    for (const Process& process : sample.processes) {
+      processSample(body, "monitor_process_cpu_utilization_ratio", process);
+      share(body, process.CpuUtilization());
+      body.push_back('\n');
+    }
+    family(body, "monitor_process_resident_memory_bytes", "gauge", "bytes",
+           "Resident set of a top process, in whole megabytes.");
+    for (const Process& process : sample.processes) {
+      processSample(body, "monitor_process_resident_memory_bytes", process);
+      number(body, static_cast<long long>(process.RamMb()) << 20);
+      body.push_back('\n');
+    }
+    family(body, "monitor_process_uptime_seconds", "gauge", "seconds",
+           "Time since a top process started.");
+    for (const Process& process : sample.processes) {
+      processSample(body, "monitor_process_uptime_seconds", process);
+      number(body, process.UpTime());
+      body.push_back('\n');
+    }
+  }
+  if (enabled & Bit(Id::kIo)) {
+    family(body, "monitor_process_read_bytes_per_second", "gauge", nullptr,
+           "Storage reads of a top process over the last interval, 0 if "
+           "it was not selected for I/O sampling.");
+    for (const Process& process : sample.processes) {
+      processSample(body, "monitor_process_read_bytes_per_second", process);
+      number(body, std::uint64_t(process.ReadRate()));
+      body.push_back('\n');
+    }
+    family(body, "monitor_process_write_bytes_per_second", "gauge", nullptr,
+           "Storage writes of a top process over the last interval, 0 if "
+           "it was not selected for I/O sampling.");
+    for (const Process& process : sample.processes) {
+      processSample(body, "monitor_process_write_bytes_per_second", process);
+      number(body, std::uint64_t(process.WriteRate()));
+      body.push_back('\n');
+    }
+  }
+
+  if (enabled & Bit(Id::kDevices)) {
+    family(body, "monitor_disk_read_bytes_per_second", "gauge", nullptr,
+           "Bytes read from a disk over the last interval.");
+    for (const DiskSample& disk : sample.disks) {
+      deviceSample(body, "monitor_disk_read_bytes_per_second", "device",
+                   disk.name);
+      number(body, std::uint64_t(disk.readRate));
+      body.push_back('\n');
+    }
+    family(body, "monitor_disk_write_bytes_per_second", "gauge", nullptr,
+           "Bytes written to a disk over the last interval.");
+    for (const DiskSample& disk : sample.disks) {
+      deviceSample(body, "monitor_disk_write_bytes_per_second", "device",
+                   disk.name);
+      number(body, std::uint64_t(disk.writeRate));
+      body.push_back('\n');
+    }
+    family(body, "monitor_disk_operations_per_second", "gauge", nullptr,
+           "Completed reads and writes of a disk over the last interval.");
+    for (const DiskSample& disk : sample.disks) {
+      deviceSample(body, "monitor_disk_operations_per_second", "device",
+                   disk.name);
+      number(body, std::uint64_t(disk.iops));
+      body.push_back('\n');
+    }
+    family(body, "monitor_disk_utilization_ratio", "gauge", "ratio",
+           "Share of the last interval a disk had requests in flight.");
+    for (const DiskSample& disk : sample.disks) {
+      deviceSample(body, "monitor_disk_utilization_ratio", "device",
+                   disk.name);
+      share(body, disk.utilization);
+      body.push_back('\n');
+    }
+    family(body, "monitor_network_receive_bytes_per_second", "gauge",
+           nullptr, "Bytes received on an interface over the last interval.");
+    for (const InterfaceSample& interface : sample.interfaces) {
+      deviceSample(body, "monitor_network_receive_bytes_per_second",
+                   "interface", interface.name);
+      number(body, std::uint64_t(interface.receiveRate));
+      body.push_back('\n');
+    }
+    family(body, "monitor_network_transmit_bytes_per_second", "gauge",
+           nullptr, "Bytes sent on an interface over the last interval.");
+    for (const InterfaceSample& interface : sample.interfaces) {
+      deviceSample(body, "monitor_network_transmit_bytes_per_second",
+                   "interface", interface.name);
+      number(body, std::uint64_t(interface.transmitRate));
+      body.push_back('\n');
+    }
+  }
+  body.append("# EOF\n");
+}
+
+Exporter::Server::~Server() {
+  if (thread_.joinable()) {
+    const std::uint64_t stop{1};
+    ssize_t written = write(wake_, &stop, sizeof(stop));
+    static_cast<void>(written);
+    thread_.join();
+  }
+  for (const auto& [fd, connection] : connections_) {
+    close(fd);
+  }
+  for (int fd : {listener_, epoll_, wake_, timer_}) {
+    if (fd >= 0) {
+      close(fd);
+    }
+  }
+  if (!path_.empty()) {
+    unlink(path_.c_str());
+  }
+}
+
+bool Exporter::Server::Listen(const Address& address, std::string& error) {
+  const int domain = address.path.empty() ? AF_INET : AF_UNIX;
+  listener_ = socket(domain, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (listener_ < 0) {
+    error = systemError("socket");
+    return false;
+  }
+  int bound;
+  std::string name;
+  if (domain == AF_UNIX) {
+    name = address.path;
+    // Replace the socket a previous run left behind, but nothing else
+    struct stat status;
+    if (lstat(name.c_str(), &status) == 0 && S_ISSOCK(status.st_mode)) {
+      unlink(name.c_str());
+    }
+    sockaddr_un local{};
+    local.sun_family = AF_UNIX;
+    std::strncpy(local.sun_path, name.c_str(), sizeof(local.sun_path) - 1);
+    bound = bind(listener_, reinterpret_cast<sockaddr*>(&local),
+                 sizeof(local));
+    if (bound == 0) {
+      path_ = name;
+    }
+  } else {
+    name = "127.0.0.1:" + std::to_string(address.port);
+    const int reuse{1};
+    setsockopt(listener_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    sockaddr_in local{};
+    local.sin_family = AF_INET;
+    local.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    local.sin_port = htons(address.port);
+    bound = bind(listener_, reinterpret_cast<sockaddr*>(&local),
+                 sizeof(local));
+  }
+  if (bound != 0 || listen(listener_, SOMAXCONN) != 0) {
+    error = systemError(name);
+    return false;
+  }
+
+  epoll_ = epoll_create1(EPOLL_CLOEXEC);
+  wake_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  timer_ = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+  if (epoll_ < 0 || wake_ < 0 || timer_ < 0) {
+    error = systemError("epoll");
+    return false;
+  }
+  itimerspec period{};
+  period.it_interval.tv_sec = 1;
+  period.it_value.tv_sec = 1;
+  timerfd_settime(timer_, 0, &period, nullptr);
+  for (int fd : {listener_, wake_, timer_}) {
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+    epoll_ctl(epoll_, EPOLL_CTL_ADD, fd, &event);
+  }
+  thread_ = std::thread(&Server::Loop, this);
+  return true;
+}
+
+// The body is rendered into a fresh buffer, the previous one is freed by
+// whichever of Publish() and the connections sending it lets go last.
+void Exporter::Server::Publish(const Sample& sample, Collectors::Set enabled) {
+  auto response = std::make_shared<Response>();
+  response->body.reserve(capacity_);
+  Render(sample, enabled, response->body);
+  capacity_ = response->body.size();
+  response->header =
+      "HTTP/1.1 200 OK\r\n"
+      "Content-Type: application/openmetrics-text; version=1.0.0; "
+      "charset=utf-8\r\n"
+      "Content-Length: " +
+      std::to_string(response->body.size()) + "\r\n\r\n";
+  std::shared_ptr<const Response> previous = std::move(response);
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::swap(latest_, previous);
+}
+
+std::uint64_t Exporter::Server::Scrapes() const {
+  return scrapes_.load(std::memory_order_relaxed);
+}
+
+void Exporter::Server::Loop() {
+  epoll_event events[64];
+  while (true) {
+    const int ready = epoll_wait(epoll_, events, 64, -1);
+    if (ready < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return;
+    }
+    for (int i = 0; i < ready; ++i) {
+      const int fd = events[i].data.fd;
+      if (fd == wake_) {
+        return;
+      }
+      if (fd == listener_) {
+        Accept();
+        continue;
+      }
+      if (fd == timer_) {
+        std::uint64_t expirations;
+        ssize_t got = read(timer_, &expirations, sizeof(expirations));
+        static_cast<void>(got);
+        Sweep();
+        continue;
+      }
+      auto found = connections_.find(fd);
+      if (found == connections_.end()) {
+        continue;
+      }
+      bool open = (events[i].events & (EPOLLERR | EPOLLHUP)) == 0;
+      if (open && (events[i].events & EPOLLIN)) {
+        open = Receive(fd, found->second);
+      }
+      // Also resumes a response the socket had no room for
+      if (open) {
+        open = Serve(fd, found->second);
+      }
+      if (!open) {
+        Close(fd);
+      }
+    }
+  }
+}
+
+// The listener is level triggered: a connection left pending would wake
+// the loop again at once, so accepting stops instead while none can be
+// taken
+void Exporter::Server::Accept() {
+  while (connections_.size() < kMaxConnections) {
+    const int fd =
+        accept4(listener_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd < 0) {
+      if (errno == EINTR || errno == ECONNABORTED) {
+        continue;
+      }
+      if (errno == EMFILE || errno == ENFILE || errno == ENOBUFS ||
+          errno == ENOMEM) {
+        Accepting(false);
+      }
+      // Otherwise EAGAIN, drained
+      return;
+    }
+    epoll_event event{};
+    event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+    event.data.fd = fd;
+    if (epoll_ctl(epoll_, EPOLL_CTL_ADD, fd, &event) != 0) {
+      close(fd);
+      continue;
+    }
+    Connection& connection = connections_[fd];
+    connection = Connection{};
+    connection.active = std::chrono::steady_clock::now();
+  }
+  Accepting(false);
+}
+
+void Exporter::Server::Accepting(bool accepting) {
+  if (accepting == accepting_) {
+    return;
+  }
+  epoll_event event{};
+  if (accepting) {
+    event.events = EPOLLIN;
+  }
+  event.data.fd = listener_;
+  epoll_ctl(epoll_, EPOLL_CTL_MOD, listener_, &event);
+  accepting_ = accepting;
+}
+
+void Exporter::Server::Close(int fd) {
+  close(fd);
+  connections_.erase(fd);
+  Accepting(true);
+}
+
+// Runs every second. Also retries accepting, which stopped for want of
+// descriptors with no connection of its own to close.
+void Exporter::Server::Sweep() {
+  const auto now = std::chrono::steady_clock::now();
+  for (auto connection = connections_.begin();
+       connection != connections_.end();) {
+    const Connection& current = connection->second;
+    const bool idle =
+        current.request.empty() && current.response == nullptr;
+    if (now - current.active > (idle ? kIdleTimeout : kStallTimeout)) {
+      close(connection->first);
+      connection = connections_.erase(connection);
+    } else {
+      ++connection;
+    }
+  }
+  if (connections_.size() < kMaxConnections) {
+    Accepting(true);
+  }
+}
+
+// Edge triggered, so read until the socket is drained
+bool Exporter::Server::Receive(int fd, Connection& connection) {
+  char buffer[4096];
+  while (true) {
+    const ssize_t received = read(fd, buffer, sizeof(buffer));
+    if (received > 0) {
+      connection.request.append(buffer, received);
+      if (connection.request.size() > kMaxRequest) {
+        return false;
+      }
+      continue;
+    }
+    if (received == 0) {
+      // Possibly only its sending side, answer what it sent
+      connection.hungUp = true;
+      return true;
+    }
+    if (errno == EINTR) {
+      continue;
+    }
+    return errno == EAGAIN || errno == EWOULDBLOCK;
+  }
+}
+
+// Finish the response in flight, then answer the requests queued behind it
+bool Exporter::Server::Serve(int fd, Connection& connection) {
+  while (true) {
+    if (connection.response != nullptr) {
+      if (!Send(fd, connection)) {
+        return false;
+      }
+      if (connection.response != nullptr) {
+        // The socket is full, EPOLLOUT resumes
+        return true;
+      }
+      if (connection.close) {
+        return false;
+      }
+    }
+    if (!Answer(connection)) {
+      return !connection.hungUp;
+    }
+  }
+}
+
+bool Exporter::Server::Send(int fd, Connection& connection) {
+  const Response& response = *connection.response;
+  const std::size_t size = response.header.size() + response.body.size();
+  while (connection.sent < size) {
+    iovec parts[2];
+    int count = 0;
+    if (connection.sent < response.header.size()) {
+      parts[count].iov_base =
+          const_cast<char*>(response.header.data()) + connection.sent;
+      parts[count].iov_len = response.header.size() - connection.sent;
+      ++count;
+    }
+    const std::size_t offset =
+        connection.sent > response.header.size()
+            ? connection.sent - response.header.size()
+            : 0;
+    parts[count].iov_base = const_cast<char*>(response.body.data()) + offset;
+    parts[count].iov_len = response.body.size() - offset;
+    ++count;
+    const ssize_t written = writev(fd, parts, count);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+    connection.sent += written;
+    connection.active = std::chrono::steady_clock::now();
+  }
+  connection.response.reset();
+  connection.sent = 0;
+  scrapes_.fetch_add(1, std::memory_order_relaxed);
+  return true;
+}
+
+bool Exporter::Server::Answer(Connection& connection) {
+  static const std::shared_ptr<const Response> notFound =
+      fixedResponse("404 Not Found");
+  static const std::shared_ptr<const Response> notAllowed =
+      fixedResponse("405 Method Not Allowed");
+  static const std::shared_ptr<const Response> unavailable =
+      fixedResponse("503 Service Unavailable");
+
+  const std::size_t end = connection.request.find("\r\n\r\n");
+  if (end == std::string::npos) {
+    return false;
+  }
+  // Request line: METHOD TARGET VERSION
+  const std::string_view header(connection.request.data(), end + 2);
+  const std::string_view line = header.substr(0, header.find("\r\n"));
+  const std::size_t space = line.find(' ');
+  const std::size_t last = line.rfind(' ');
+  const std::string_view method = line.substr(0, space);
+  const std::string_view target =
+      space < last ? line.substr(space + 1, last - space - 1) : "";
+  const std::string_view version =
+      space < last ? line.substr(last + 1) : "";
+
+  if (method != "GET") {
+    connection.response = notAllowed;
+    connection.close = true;
+  } else if (target != "/metrics" && target.substr(0, 9) != "/metrics?") {
+    connection.response = notFound;
+  } else {
+    std::lock_guard<std::mutex> lock(mutex_);
+    connection.response = latest_ != nullptr ? latest_ : unavailable;
+  }
+  connection.close = connection.close || closeRequested(header, version);
+  connection.request.erase(0, end + 4);
+  connection.active = std::chrono::steady_clock::now();
+  return true;
+}
+
+int Exporter::Run(System& system, const Options& options,
+                  Recording::Writer* recorder) {
+  Server server;
+  std::string error;
+  if (!server.Listen(options.exportTo, error)) {
+    std::fprintf(stderr, "%s\n", error.c_str());
+    return 1;
+  }
+
+  SampleLoop::Run(system, options, 0, recorder, [&](const Sample& sample) {
+    server.Publish(sample, system.Enabled());
+    return true;
+  });
+  return 0;
+}
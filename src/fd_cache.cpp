@@ -0,0 +1,172 @@
+#include "fd_cache.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+
+ProcFile::~ProcFile() {
+  if (fd_ >= 0) {
+    close(fd_);
+  }
+}
+
+// Read the whole file with pread() from offset 0
+bool ProcFile::Read(const std::string& path, std::string& buffer) {
+  if (fd_ < 0 || path != path_) {
+    if (fd_ >= 0) {
+      close(fd_);
+    }
+    path_ = path;
+    fd_ = open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd_ < 0) {
+      return false;
+    }
+  }
+
+  buffer.resize(std::max<std::size_t>(buffer.capacity(), 4096));
+  std::size_t length = 0;
+  ssize_t count;
+  while ((count = pread(fd_, &buffer[length], buffer.size() - length,
+                        length)) > 0) {
+    length += count;
+    if (length == buffer.size()) {
+      buffer.resize(buffer.size() * 2);
+    }
+  }
+  buffer.resize(length);
+  if (count < 0) {
+    // Try a fresh descriptor on the next call.
+    close(fd_);
+    fd_ = -1;
+    return false;
+  }
+  return true;
+}
+
+namespace {
+// Descriptors all PidFileCaches may still keep open. Half of the soft limit,
+// the other half is left to the rest of the program.
+std::atomic<long>& budget() {
+  static std::atomic<long> descriptors{[] {
+    rlimit limit{};
+    if (getrlimit(RLIMIT_NOFILE, &limit) != 0) {
+      return 512L;
+    }
+    if (limit.rlim_cur == RLIM_INFINITY) {
+      return 32768L;
+    }
+    return static_cast<long>(std::min<rlim_t>(limit.rlim_cur, 65536) / 2);
+  }()};
+  return descriptors;
+}
+
+// One bit per key telling whether some cache holds its descriptor. Keys that
+// share a bit are simply not cached twice.
+constexpr std::size_t kClaimBits = std::size_t{1} << 22;
+std::atomic<std::uint64_t> claims[kClaimBits / 64];
+
+bool claim(std::uint64_t key) {
+  std::uint64_t bit = std::uint64_t{1} << (key % 64);
+  return !(claims[key % kClaimBits / 64].fetch_or(bit) & bit);
+}
+
+void release(std::uint64_t key) {
+  claims[key % kClaimBits / 64].fetch_and(~(std::uint64_t{1} << (key % 64)));
+}
+
+// How long a cache waits between two sweeps of unread descriptors
+constexpr std::chrono::seconds kSweepInterval{5};
+}  // namespace
+
+PidFileCache::~PidFileCache() { Clear(); }
+
+ssize_t PidFileCache::Read(std::uint64_t key, const char* path, char* buffer,
+                           std::size_t size) {
+  auto found = entries_.find(key);
+  if (found != entries_.end()) {
+    ssize_t length = pread(found->second.fd, buffer, size, 0);
+    if (length >= 0) {
+      found->second.read = true;
+      return length;
+    }
+    // ESRCH: the process exited, the pid may belong to a new one by now.
+    Close(key, found->second.fd);
+    entries_.erase(found);
+  }
+
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0 && (errno == EMFILE || errno == ENFILE) && !entries_.empty()) {
+    auto victim = entries_.begin();
+    Close(victim->first, victim->second.fd);
+    entries_.erase(victim);
+    fd = open(path, O_RDONLY | O_CLOEXEC);
+  }
+  if (fd < 0) {
+    return -1;
+  }
+  ssize_t length = pread(fd, buffer, size, 0);
+  if (length < 0 || !Admit(key)) {
+    close(fd);
+    return length;
+  }
+  entries_.emplace(key, Entry{fd, true});
+  return length;
+}
+
+// Close every cached descriptor
+void PidFileCache::Clear() {
+  for (const auto& [key, entry] : entries_) {
+    Close(key, entry.fd);
+  }
+  entries_.clear();
+}
+
+std::size_t PidFileCache::Size() const { return entries_.size(); }
+
+// Take one descriptor from the shared budget and claim key for this cache.
+// Cached descriptors are never given up to make room, so a full budget means
+// the file is read without caching (after sweeping at most every few
+// seconds).
+bool PidFileCache::Admit(std::uint64_t key) {
+  if (budget().load(std::memory_order_relaxed) <= 0) {
+    auto now = std::chrono::steady_clock::now();
+    if (now - swept_ < kSweepInterval) {
+      return false;
+    }
+    swept_ = now;
+    Sweep();
+  }
+  if (--budget() < 0) {
+    ++budget();
+    return false;
+  }
+  if (!claim(key)) {
+    ++budget();
+    return false;
+  }
+  return true;
+}
+
+// Close a cached descriptor and give its budget and claim back
+void PidFileCache::Close(std::uint64_t key, int fd) {
+  close(fd);
+  release(key);
+  ++budget();
+}
+
+// Close the descriptors not read since the previous sweep
+void PidFileCache::Sweep() {
+  for (auto it = entries_.begin(); it != entries_.end();) {
+    if (it->second.read) {
+      it->second.read = false;
+      ++it;
+    } else {
+      Close(it->first, it->second.fd);
+      it = entries_.erase(it);
+    }
+  }
+}
@@ -1,24 +1,27 @@
 #include "format.h"
 
+#include <charconv>
 #include <chrono>
-#include <iomanip>
-#include <sstream>
 #include <string>
 
-std::string Format::ElapsedTime(long s) {
-  /*
-  std::ostringstream hours, minutes, secs; hours <<
-  std::setfill('0') << std::setw(2) << (seconds / 3600); seconds = seconds %
-  3600; minutes << std::setfill('0') << std::setw(2) << seconds / 60; secs <<
-  std::setfill('0') << std::setw(2) << seconds % 60; return hours.str() + ":" +
-  minutes.str() + ":" + secs.str();
+namespace {
+// Write value with at least two digits
+char* TwoDigits(char* out, char* end, long value) {
+  if (value < 10) {
+    *out++ = '0';
+  }
+  return std::to_chars(out, end, value).ptr;
+}
+}  // namespace
 
-  old implementation. Due to Udacitys Review Comment changed to the more
-  expressive solution below. Copied line by line from the Review suggestion.
-  */
+std::string Format::ElapsedTime(long s) {
+  char buffer[kElapsedTimeSize];
+  return std::string(buffer, ElapsedTime(s, buffer));
+}
 
+std::size_t Format::ElapsedTime(long s, char (&buffer)[kElapsedTimeSize]) {
   // return std::chrono::format("%T", seconds); // in C++20
-  std::chrono::seconds seconds{s};
+  std::chrono::seconds seconds{s < 0 ? 0 : s};
 
   std::chrono::hours hours =
       std::chrono::duration_cast<std::chrono::hours>(seconds);
@@ -30,13 +33,11 @@ std::string Format::ElapsedTime(long s) {
 
   seconds -= std::chrono::duration_cast<std::chrono::seconds>(minutes);
 
-  std::stringstream ss{};
-
-  ss << std::setw(2) << std::setfill('0') << hours.count()     // HH
-     << std::setw(1) << ":"                                    // :
-     << std::setw(2) << std::setfill('0') << minutes.count()   // MM
-     << std::setw(1) << ":"                                    // :
-     << std::setw(2) << std::setfill('0') << seconds.count();  // SS
-
-  return ss.str();
-}
\ No newline at end of file
+  char* const end = buffer + kElapsedTimeSize;
+  char* out = TwoDigits(buffer, end, hours.count());   // HH
+  *out++ = ':';                                        // :
+  out = TwoDigits(out, end, minutes.count());          // MM
+  *out++ = ':';                                        // :
+  out = TwoDigits(out, end, seconds.count());          // SS
+  return out - buffer;
+}
@@ -2,15 +2,125 @@
 
 #include <ctype.h>
 #include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
 #include <unistd.h>
 
-#include <filesystem>
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cstring>
 #include <string>
 #include <vector>
 
+#include "fd_cache.h"
+#include "pid_scanner.h"
+#include "profiler.h"
+#include "user_cache.h"
+
+namespace {
+std::string procDirectory{LinuxParser::kProcDirectory};
+std::string passwordPath{LinuxParser::kPasswordPath};
+// Empty until CgroupDirectory() looked it up or it was set
+std::string cgroupDirectory;
+// Bumped whenever procDirectory changes, so cached descriptors get dropped
+std::atomic<unsigned> procGeneration{0};
+UserCache userCache;
+
+// Write "<proc>/<pid><filename>" into buffer without allocating. Returns false
+// if the path does not fit.
+bool pidPath(char* buffer, std::size_t size, int pid,
+             const std::string& filename) {
+  const std::string& proc = LinuxParser::ProcDirectory();
+  char* const end = buffer + size;
+  if (proc.size() >= size) {
+    return false;
+  }
+  char* cursor = std::copy(proc.begin(), proc.end(), buffer);
+  auto [next, error] = std::to_chars(cursor, end, pid);
+  if (error != std::errc() || next + filename.size() >= end) {
+    return false;
+  }
+  cursor = std::copy(filename.begin(), filename.end(), next);
+  *cursor = '\0';
+  return true;
+}
+
+// Read a whole (small) file into buffer with a single read(). Returns the
+// number of bytes read or -1.
+ssize_t readFile(const char* path, char* buffer, std::size_t size) {
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return -1;
+  }
+  ssize_t length = read(fd, buffer, size);
+  close(fd);
+  return length;
+}
+
+// Per-pid files that are read every tick and worth keeping open. status,
+// cmdline and exe are only read once per process, see ReadProcess().
+enum PidFile { kStatFile = 0, kIoFile = 1 };
+
+// Read /proc/<pid>/<filename> through the calling thread's descriptor cache
+ssize_t readPidFile(int pid, PidFile file, const std::string& filename,
+                    char* buffer, std::size_t size) {
+  thread_local PidFileCache cache;
+  thread_local unsigned generation{procGeneration};
+  if (generation != procGeneration) {
+    cache.Clear();
+    generation = procGeneration;
+  }
+  char path[256];
+  if (!pidPath(path, sizeof(path), pid, filename)) {
+    return -1;
+  }
+  return cache.Read(std::uint64_t(pid) << 1 | file, path, buffer, size);
+}
+
+// A system wide /proc file, kept open by every thread that reads it
+struct HotFile {
+  ProcFile file;
+  std::string path;
+  std::string content;
+  unsigned generation{~0u};
+
+  bool Read(const std::string& filename) {
+    if (generation != procGeneration) {
+      path = LinuxParser::ProcDirectory() + filename;
+      generation = procGeneration;
+    }
+    return file.Read(path, content);
+  }
+};
+
+// Return the value after key and the following blanks if line (up to eol)
+// starts with key followed by a blank, otherwise nullptr
+const char* fieldValue(const char* line, const char* eol,
+                       const std::string& key) {
+  if (eol - line <= static_cast<long>(key.size()) ||
+      std::memcmp(line, key.data(), key.size()) != 0 ||
+      (line[key.size()] != ' ' && line[key.size()] != '\t')) {
+    return nullptr;
+  }
+  const char* cursor = line + key.size();
+  while (cursor < eol && (*cursor == ' ' || *cursor == '\t')) {
+    ++cursor;
+  }
+  return cursor;
+}
+
+// Return the end of the line starting at cursor
+const char* lineEnd(const char* cursor, const char* end) {
+  const char* eol =
+      static_cast<const char*>(std::memchr(cursor, '\n', end - cursor));
+  return eol ? eol : end;
+}
+}  // namespace
+
 template <typename TValue>
 TValue parseFile(std::string key, std::string path) {
-  TValue value;
+  TValue value{};
   std::string foundKey;
   std::string line;
 
@@ -33,7 +143,7 @@ TValue parseFile(std::string key, std::string path) {
 
 template <typename TValue>
 TValue parseFile(std::string path) {
-  TValue value;
+  TValue value{};
   std::string line;
 
   if (!(path.empty())) {
@@ -48,6 +158,53 @@ TValue parseFile(std::string path) {
   return value;
 }
 
+// Return the proc root all parser functions read from
+const std::string& LinuxParser::ProcDirectory() { return procDirectory; }
+
+// Redirect the proc root, a trailing '/' is added if missing
+void LinuxParser::SetProcDirectory(const std::string& path) {
+  procDirectory = path;
+  if (procDirectory.empty() || procDirectory.back() != '/') {
+    procDirectory += '/';
+  }
+  ++procGeneration;
+}
+
+// Return the passwd file used to resolve user names
+const std::string& LinuxParser::PasswordPath() { return passwordPath; }
+
+// Redirect the passwd file used to resolve user names
+void LinuxParser::SetPasswordPath(const std::string& path) {
+  passwordPath = path;
+}
+
+const std::string& LinuxParser::CgroupDirectory() {
+  if (!cgroupDirectory.empty()) {
+    return cgroupDirectory;
+  }
+  cgroupDirectory = kCgroupDirectory;
+  std::ifstream mounts(ProcDirectory() + kMountsFilename);
+  std::string device;
+  std::string mountPoint;
+  std::string type;
+  std::string rest;
+  while (mounts >> device >> mountPoint >> type && std::getline(mounts, rest)) {
+    if (type == "cgroup2") {
+      cgroupDirectory = mountPoint;
+      break;
+    }
+  }
+  return cgroupDirectory;
+}
+
+// Redirect the cgroup v2 root, a trailing '/' is dropped
+void LinuxParser::SetCgroupDirectory(const std::string& path) {
+  cgroupDirectory = path;
+  while (cgroupDirectory.size() > 1 && cgroupDirectory.back() == '/') {
+    cgroupDirectory.pop_back();
+  }
+}
+
 // An example of how to read data from the filesystem
 std::string LinuxParser::OperatingSystem() {
   std::string line;
@@ -78,7 +235,7 @@ std::string LinuxParser::OperatingSystem() {
 std::string LinuxParser::Kernel() {
   std::string os, version, kernel;
   std::string line;
-  std::ifstream stream(LinuxParser::kProcDirectory +
+  std::ifstream stream(LinuxParser::ProcDirectory() +
                        LinuxParser::kVersionFilename);
   if (stream.is_open()) {
     std::getline(stream, line);
@@ -90,118 +247,128 @@ std::string LinuxParser::Kernel() {
   return kernel;
 }
 
-// BONUS: Update this to use filesystem
+// Return the pids in ProcDirectory(), ascending
 std::vector<int> LinuxParser::Pids() {
-  std::vector<int> pids;
-  const std::filesystem::path dir{LinuxParser::kProcDirectory};
-
-  for (auto const& dir_entry : std::filesystem::directory_iterator{dir}) {
-    if (dir_entry.is_directory()) {
-      std::string filename{dir_entry.path().filename()};
-      if (std::all_of(filename.begin(), filename.end(), isdigit)) {
-        try {
-          int pid = stoi(filename);
-          pids.emplace_back(pid);
-        } catch (...) {
-          // do nothing
-        }
-      }
-    }
-  }
-
-  return pids;
+  thread_local PidScanner scanner;
+  scanner.Scan(LinuxParser::ProcDirectory());
+  return scanner.Pids();
 }
 
 // Read and return the system memory utilization
 float LinuxParser::MemoryUtilization() {
-  float memTotal =
-      parseFile<float>(filterMemTotal, LinuxParser::kProcDirectory +
-                                           LinuxParser::kMeminfoFilename);
-  float memFree =
-      parseFile<float>(filterMemAvailable, LinuxParser::kProcDirectory +
-                                               LinuxParser::kMeminfoFilename);
+  thread_local HotFile file;
+  if (!file.Read(kMeminfoFilename)) {
+    return 0;
+  }
 
-  return (memTotal - memFree) / memTotal;
+  float memTotal = 0;
+  float memFree = 0;
+  const char* cursor = file.content.data();
+  const char* const end = cursor + file.content.size();
+  while (cursor < end && (memTotal == 0 || memFree == 0)) {
+    const char* eol = lineEnd(cursor, end);
+    const char* value;
+    if ((value = fieldValue(cursor, eol, filterMemTotal))) {
+      std::from_chars(value, eol, memTotal);
+    } else if ((value = fieldValue(cursor, eol, filterMemAvailable))) {
+      std::from_chars(value, eol, memFree);
+    }
+    cursor = eol + 1;
+  }
+
+  return memTotal > 0 ? (memTotal - memFree) / memTotal : 0;
 }
 
 // Read and return the system uptime
 long LinuxParser::UpTime() {
-  long systemUptime = parseFile<long>(LinuxParser::kProcDirectory +
-                                      LinuxParser::kUptimeFilename);
+  thread_local HotFile file;
+  long systemUptime = 0;
+  if (file.Read(kUptimeFilename)) {
+    const char* begin = file.content.data();
+    std::from_chars(begin, begin + file.content.size(), systemUptime);
+  }
 
   return systemUptime;
 }
 
 // Read and return the number of jiffies for the system
 long LinuxParser::Jiffies() {
-  return LinuxParser::ActiveJiffies() + LinuxParser::IdleJiffies();
+  StatSnapshot stat;
+  return ReadStat(stat) ? stat.cpus.total[0] : 0;
 }
 
 // Read and return the number of active jiffies for a PID
 long LinuxParser::ActiveJiffies(int pid) {
-  std::string line, value;
-  std::vector<std::string> jiffies;
-
-  std::ifstream stream(LinuxParser::kProcDirectory + std::to_string(pid) +
-                       LinuxParser::kStatFilename);
-  if (stream.is_open()) {
-    std::getline(stream, line);
-    std::istringstream linestream(line);
-    while (linestream >> value) {
-      jiffies.emplace_back(value);
-    }
-  }
-  stream.close();
-
-  long activeTime;
-  try {
-    if (jiffies.size() >= 16) {
-      activeTime = std::stol(jiffies[13]) + std::stol(jiffies[14]) +
-                   std::stol(jiffies[15]) + std::stol(jiffies[16]);
-    }
-  } catch (...) {
-    activeTime = 0;
+  ProcStat stat;
+  if (!ParseStat(pid, stat)) {
+    return 0;
   }
-
-  return activeTime / sysconf(_SC_CLK_TCK);
+  return stat.utime + stat.stime + stat.cutime + stat.cstime;
 }
 
 // Read and return the number of active jiffies for the system
 long LinuxParser::ActiveJiffies() {
-  auto jiffies = CpuUtilization();
-
-  long activeTime;
-  try {
-    if (jiffies.size() >= CPUStates::kSteal_) {
-      activeTime = std::stol(jiffies[CPUStates::kUser_]) +
-                   std::stol(jiffies[CPUStates::kNice_]) +
-                   std::stol(jiffies[CPUStates::kSystem_]) +
-                   std::stol(jiffies[CPUStates::kIRQ_]) +
-                   std::stol(jiffies[CPUStates::kSoftIRQ_]) +
-                   std::stol(jiffies[CPUStates::kSteal_]);
-    }
-  } catch (...) {
-    activeTime = 0;
-  }
-
-  return activeTime / sysconf(_SC_CLK_TCK);
+  StatSnapshot stat;
+  return ReadStat(stat) ? stat.cpus.total[0] - stat.cpus.idle[0] : 0;
 }
 
 // Read and return the number of idle jiffies for the system
 long LinuxParser::IdleJiffies() {
-  auto jiffies = CpuUtilization();
+  StatSnapshot stat;
+  return ReadStat(stat) ? stat.cpus.idle[0] : 0;
+}
 
-  long idleTime;
-  try {
-    if (jiffies.size() >= CPUStates::kIOwait_) {
-      idleTime = std::stol(jiffies[CPUStates::kIdle_]) +
-                 std::stol(jiffies[CPUStates::kIOwait_]);
-    }
-  } catch (...) {
-    idleTime = 0;
+// Read /proc/stat once and parse the cpu lines and counters the monitor uses
+bool LinuxParser::ReadStat(StatSnapshot& stat) {
+  thread_local HotFile file;
+  CpuJiffies& cpus = stat.cpus;
+  cpus.total.clear();
+  cpus.idle.clear();
+  cpus.steal.clear();
+  if (!file.Read(kStatFilename)) {
+    return false;
   }
 
-  return idleTime / sysconf(_SC_CLK_TCK);
+  const char* cursor = file.content.data();
+  const char* const end = cursor + file.content.size();
+  while (cursor < end) {
+    const char* eol = lineEnd(cursor, end);
+    const char* number;
+    if (eol - cursor > 3 && std::memcmp(cursor, "cpu", 3) == 0) {
+      const char* field =
+          static_cast<const char*>(std::memchr(cursor, ' ', eol - cursor));
+      unsigned long long states[CPUStates::kGuestNice_ + 1] = {};
+      for (auto& state : states) {
+        while (field && field < eol && *field == ' ') {
+          ++field;
+        }
+        if (field == nullptr || field >= eol) {
+          break;
+        }
+        field = std::from_chars(field, eol, state).ptr;
+      }
+      const double idle = states[kIdle_] + states[kIOwait_];
+      const double active = states[kUser_] + states[kNice_] +
+                            states[kSystem_] + states[kIRQ_] +
+                            states[kSoftIRQ_] + states[kSteal_];
+      cpus.total.emplace_back(active + idle);
+      cpus.idle.emplace_back(idle);
+      cpus.steal.emplace_back(states[kSteal_]);
+    } else if ((number = fieldValue(cursor, eol, filterInterrupts))) {
+      // Only the total, the per interrupt counts follow it.
+      std::from_chars(number, eol, stat.interrupts);
+    } else if ((number = fieldValue(cursor, eol, filterContextSwitches))) {
+      std::from_chars(number, eol, stat.contextSwitches);
+    } else if ((number = fieldValue(cursor, eol, filterProcesses))) {
+      std::from_chars(number, eol, stat.processes);
+    } else if ((number = fieldValue(cursor, eol, filterRunningProcesses))) {
+      std::from_chars(number, eol, stat.procsRunning);
+    } else if ((number = fieldValue(cursor, eol, filterBlockedProcesses))) {
+      std::from_chars(number, eol, stat.procsBlocked);
+    }
+    cursor = eol + 1;
+  }
+  return !cpus.total.empty();
 }
 
 // Read and return CPU utilization
@@ -209,7 +376,7 @@ std::vector<std::string> LinuxParser::CpuUtilization() {
   std::string line, cpu, value;
   std::vector<std::string> jiffies;
 
-  std::ifstream stream(LinuxParser::kProcDirectory +
+  std::ifstream stream(LinuxParser::ProcDirectory() +
                        LinuxParser::kStatFilename);
   if (stream.is_open()) {
     std::getline(stream, line);
@@ -226,31 +393,24 @@ std::vector<std::string> LinuxParser::CpuUtilization() {
 
 // Read and return the total number of processes
 int LinuxParser::TotalProcesses() {
-  int processes;
-
-  processes = parseFile<int>(filterProcesses, LinuxParser::kProcDirectory +
-                                                  LinuxParser::kStatFilename);
-
-  return processes;
+  StatSnapshot stat;
+  ReadStat(stat);
+  return stat.processes;
 }
 
 // Read and return the number of running processes
 int LinuxParser::RunningProcesses() {
-  int processes;
-
-  processes =
-      parseFile<int>(filterRunningProcesses,
-                     LinuxParser::kProcDirectory + LinuxParser::kStatFilename);
-
-  return processes;
+  StatSnapshot stat;
+  ReadStat(stat);
+  return stat.procsRunning;
 }
 
-// Read and return the command associated with a process
+// Read and return the command associated with a process, arguments
+// separated by spaces
 std::string LinuxParser::Command(int pid) {
-  std::string command =
-      parseFile<std::string>(LinuxParser::kProcDirectory + std::to_string(pid) +
-                             LinuxParser::kCmdlineFilename);
-
+  std::string command;
+  ReadCommand(pid, command);
+  std::replace(command.begin(), command.end(), '\0', ' ');
   return command;
 }
 
@@ -262,7 +422,7 @@ std::string LinuxParser::Ram(int pid) {
   // physical memory is given by VmRSS. Given link by Reviewer:
   // https://man7.org/linux/man-pages/man5/proc.5.html
   std::string memory = parseFile<std::string>(
-      filterProcMem, LinuxParser::kProcDirectory + std::to_string(pid) +
+      filterProcMem, LinuxParser::ProcDirectory() + std::to_string(pid) +
                          LinuxParser::kStatusFilename);
   int scaledMem = 0;
   try {
@@ -277,7 +437,7 @@ std::string LinuxParser::Ram(int pid) {
 // Read and return the user ID associated with a process
 std::string LinuxParser::Uid(int pid) {
   std::string uid = parseFile<std::string>(
-      filterUID, LinuxParser::kProcDirectory + std::to_string(pid) +
+      filterUID, LinuxParser::ProcDirectory() + std::to_string(pid) +
                      LinuxParser::kStatusFilename);
 
   return uid;
@@ -286,49 +446,435 @@ std::string LinuxParser::Uid(int pid) {
 // Read and return the user associated with a process
 std::string LinuxParser::User(int pid) {
   std::string uid = Uid(pid);
-  std::string id, not_used, foundName, line;
-  std::string name;
+  RefreshUsers();
+  try {
+    return UserByUid(std::stoi(uid));
+  } catch (...) {
+    return std::string();
+  }
+}
 
-  std::ifstream stream(LinuxParser::kPasswordPath);
-  if (stream.is_open()) {
-    while (std::getline(stream, line)) {
-      std::replace(line.begin(), line.end(), ':', ' ');
-      std::istringstream linestream(line);
+// Return the user name of a uid, see RefreshUsers()
+// A hash lookup, cheaper than timing it; kPasswd covers the refresh.
+const std::string& LinuxParser::UserByUid(int uid) {
+  return userCache.Name(uid);
+}
+
+// Pick up changes of the passwd file. Called once per refresh, so lookups in
+// between never touch the file system.
+void LinuxParser::RefreshUsers() {
+  PROFILE_SCOPE(kPasswd);
+  userCache.Refresh(PasswordPath());
+}
+
+// Read and return the uptime of a process
+long LinuxParser::UpTime(int pid) {
+  ProcStat stat;
+  if (!ParseStat(pid, stat)) {
+    return 0;
+  }
+  return stat.starttime / sysconf(_SC_CLK_TCK);
+}
+
+// Read /proc/[pid]/stat once into a stack buffer and parse it
+bool LinuxParser::ParseStat(int pid, ProcStat& stat) {
+  // The line is ~52 numbers plus a comm of at most 64 bytes.
+  char line[1024];
+  ssize_t length =
+      readPidFile(pid, kStatFile, kStatFilename, line, sizeof(line));
+  if (length <= 0) {
+    return false;
+  }
+  return ParseStat(line, length, stat);
+}
+
+// Parse a /proc/[pid]/stat line. comm (field 2) may contain spaces and
+// parentheses, so it is skipped by searching for the last ')'.
+bool LinuxParser::ParseStat(const char* line, std::size_t size,
+                            ProcStat& stat) {
+  const char* const end = line + size;
+  const char* open = static_cast<const char*>(std::memchr(line, '(', size));
+  const char* close = static_cast<const char*>(memrchr(line, ')', size));
+  if (open == nullptr || close == nullptr || close < open) {
+    return false;
+  }
+  std::from_chars(line, open, stat.pid);
 
-      linestream >> foundName >> not_used >> id;
-      if (id == uid) {
-        name = foundName;
+  const char* cursor = close + 1;
+  for (int field = 3; cursor < end; ++field) {
+    while (cursor < end && *cursor == ' ') {
+      ++cursor;
+    }
+    if (cursor >= end || *cursor == '\n') {
+      break;
+    }
+    switch (field) {
+      case 3:
+        stat.state = *cursor;
         break;
-      }
+      case 4:
+        std::from_chars(cursor, end, stat.ppid);
+        break;
+      case 14:
+        std::from_chars(cursor, end, stat.utime);
+        break;
+      case 15:
+        std::from_chars(cursor, end, stat.stime);
+        break;
+      case 16:
+        std::from_chars(cursor, end, stat.cutime);
+        break;
+      case 17:
+        std::from_chars(cursor, end, stat.cstime);
+        break;
+      case 18:
+        std::from_chars(cursor, end, stat.priority);
+        break;
+      case 19:
+        std::from_chars(cursor, end, stat.nice);
+        break;
+      case 20:
+        std::from_chars(cursor, end, stat.numThreads);
+        break;
+      case 22:
+        std::from_chars(cursor, end, stat.starttime);
+        break;
+      case 23:
+        std::from_chars(cursor, end, stat.vsize);
+        break;
+      case 24:
+        std::from_chars(cursor, end, stat.rss);
+        break;
+      case 39:
+        std::from_chars(cursor, end, stat.processor);
+        return true;
+    }
+    cursor = static_cast<const char*>(std::memchr(cursor, ' ', end - cursor));
+    if (cursor == nullptr) {
+      break;
     }
   }
-  stream.close();
+  return stat.state != '?';
+}
 
-  return name;
+// Read stat of a process and, with metadata, status, cmdline and exe, each
+// file exactly once. snapshot may be reused, its string buffers are kept.
+// Thread safe.
+bool LinuxParser::ReadProcess(int pid, ProcessSnapshot& snapshot,
+                              bool metadata) {
+  static const long pageKb = sysconf(_SC_PAGESIZE) / 1024;
+  snapshot.stat = {};
+  snapshot.ramKb = 0;
+  snapshot.uid = -1;
+  snapshot.command.clear();
+  snapshot.exe.clear();
+  if (!ParseStat(pid, snapshot.stat)) {
+    return false;
+  }
+  snapshot.ramKb = snapshot.stat.rss * pageKb;
+  if (metadata) {
+    ReadMetadata(pid, snapshot);
+  }
+  return true;
 }
 
-// Read and return the uptime of a process
-long LinuxParser::UpTime(int pid) {
-  std::string line, value;
-  std::vector<std::string> values;
-  long starttime;
+// The uid is the first field of status that is needed
+void LinuxParser::ReadMetadata(int pid, ProcessSnapshot& snapshot) {
+  snapshot.uid = -1;
+  char path[256];
+  char buffer[4096];
+  const ssize_t length = pidPath(path, sizeof(path), pid, kStatusFilename)
+                             ? readFile(path, buffer, sizeof(buffer))
+                             : -1;
+  const char* const end = buffer + std::max<ssize_t>(length, 0);
+  for (const char* line = buffer; line < end;) {
+    const char* eol = lineEnd(line, end);
+    if (const char* uid = fieldValue(line, eol, filterUID)) {
+      std::from_chars(uid, eol, snapshot.uid);
+      break;
+    }
+    line = eol + 1;
+  }
+  ReadCommand(pid, snapshot.command);
+  ReadExe(pid, snapshot.exe);
+}
 
-  std::ifstream stream(kProcDirectory + std::to_string(pid) + kStatFilename);
-  if (stream.is_open()) {
-    std::getline(stream, line);
-    std::istringstream linestream(line);
-    while (linestream >> value) {
-      values.emplace_back(value);
+bool LinuxParser::ReadTask(int pid, int tid, TaskSnapshot& task) {
+  task.stat = {};
+  task.name.clear();
+  char path[256];
+  if (!pidPath(path, sizeof(path), pid, kTaskDirectory)) {
+    return false;
+  }
+  char* const end = path + sizeof(path);
+  auto [cursor, error] = std::to_chars(path + std::strlen(path), end, tid);
+  if (error != std::errc() || cursor + kStatFilename.size() >= end) {
+    return false;
+  }
+  *std::copy(kStatFilename.begin(), kStatFilename.end(), cursor) = '\0';
+
+  // Threads are not kept open, there are too many of them
+  char line[1024];
+  ssize_t length = readFile(path, line, sizeof(line));
+  if (length <= 0 || !ParseStat(line, length, task.stat)) {
+    return false;
+  }
+  const char* open = static_cast<const char*>(std::memchr(line, '(', length));
+  const char* close = static_cast<const char*>(memrchr(line, ')', length));
+  task.name.assign(open + 1, close);
+  return true;
+}
+
+// Take the "0::<path>" line of /proc/<pid>/cgroup, the v1 hierarchies on
+// hybrid hosts are ignored
+bool LinuxParser::ReadCgroup(int pid, std::string& path) {
+  path.clear();
+  char file[256];
+  char buffer[4096];
+  if (!pidPath(file, sizeof(file), pid, kCgroupFilename)) {
+    return false;
+  }
+  ssize_t length = readFile(file, buffer, sizeof(buffer));
+  const char* const end = buffer + std::max<ssize_t>(length, 0);
+  for (const char* line = buffer; line < end;) {
+    const char* eol = lineEnd(line, end);
+    if (eol - line >= 3 && std::memcmp(line, "0::", 3) == 0) {
+      path.assign(line + 3, eol);
+      return true;
     }
+    line = eol + 1;
   }
-  stream.close();
+  return false;
+}
 
-  try {
-    if (values.size() >= 21) {
-      starttime = std::stol(values[21]) / sysconf(_SC_CLK_TCK);
+bool LinuxParser::ReadCgroupCounters(const std::string& path,
+                                     CgroupCounters& counters) {
+  counters = {};
+  thread_local std::string file;
+  char buffer[16384];
+  const std::string& root = CgroupDirectory();
+
+  file.assign(root).append(path).append("/cpu.stat");
+  ssize_t length = readFile(file.c_str(), buffer, sizeof(buffer));
+  if (length < 0) {
+    return false;
+  }
+  const char* end = buffer + length;
+  for (const char* line = buffer; line < end;) {
+    const char* eol = lineEnd(line, end);
+    if (const char* usage = fieldValue(line, eol, filterCgroupUsage)) {
+      std::from_chars(usage, eol, counters.usageUsec);
+      break;
     }
-  } catch (...) {
-    starttime = 0;
+    line = eol + 1;
+  }
+
+  file.assign(root).append(path).append("/memory.current");
+  length = readFile(file.c_str(), buffer, sizeof(buffer));
+  if (length > 0) {
+    std::from_chars(buffer, buffer + length, counters.memoryBytes);
+  }
+
+  // One line per device: "8:0 rbytes=1 wbytes=2 rios=3 wios=4 ..."
+  file.assign(root).append(path).append("/io.stat");
+  length = readFile(file.c_str(), buffer, sizeof(buffer));
+  end = buffer + std::max<ssize_t>(length, 0);
+  for (const char* cursor = buffer; cursor < end;) {
+    const char* field = static_cast<const char*>(
+        std::memchr(cursor, 'b', end - cursor));
+    if (field == nullptr) {
+      break;
+    }
+    unsigned long long value = 0;
+    if (end - field > 7 && std::memcmp(field, "bytes=", 6) == 0 &&
+        field > buffer && (field[-1] == 'r' || field[-1] == 'w')) {
+      std::from_chars(field + 6, end, value);
+      (field[-1] == 'r' ? counters.readBytes : counters.writeBytes) += value;
+    }
+    cursor = field + 1;
+  }
+  return true;
+}
+
+// "   8       0 sda 1 2 3 4 5 6 7 8 9 10 ...": the name is the third field,
+// reads, read sectors, writes and written sectors are the 1st, 3rd, 5th and
+// 7th value after it, the busy time the 10th
+bool LinuxParser::ReadDiskStats(std::vector<DiskCounters>& disks) {
+  thread_local HotFile file;
+  std::size_t count = 0;
+  if (!file.Read(kDiskstatsFilename)) {
+    disks.clear();
+    return false;
+  }
+  const char* cursor = file.content.data();
+  const char* const end = cursor + file.content.size();
+  for (; cursor < end; cursor = lineEnd(cursor, end) + 1) {
+    const char* const eol = lineEnd(cursor, end);
+    const char* field = cursor;
+    const char* name = nullptr;
+    const char* nameEnd = nullptr;
+    unsigned long long values[10] = {};
+    int column = 0;
+    for (; column < 13; ++column) {
+      while (field < eol && *field == ' ') {
+        ++field;
+      }
+      if (field == eol) {
+        break;
+      }
+      if (column == 2) {
+        name = field;
+        nameEnd = static_cast<const char*>(
+            std::memchr(field, ' ', eol - field));
+        field = nameEnd ? nameEnd : eol;
+      } else if (column > 2) {
+        field = std::from_chars(field, eol, values[column - 3]).ptr;
+      } else {
+        field = std::from_chars(field, eol, values[0]).ptr;
+      }
+    }
+    if (column < 13 || name == nullptr) {
+      continue;
+    }
+    if (count == disks.size()) {
+      disks.emplace_back();
+    }
+    DiskCounters& disk = disks[count++];
+    disk.name.assign(name, nameEnd);
+    disk.reads = values[0];
+    disk.readSectors = values[2];
+    disk.writes = values[4];
+    disk.writeSectors = values[6];
+    disk.busyMs = values[9];
+  }
+  disks.resize(count);
+  return true;
+}
+
+// "  eth0: 1 2 3 4 5 6 7 8 9 10 ...": bytes and packets received are the
+// first two values, bytes and packets sent the 9th and 10th. The first two
+// lines are headers, which have no colon before the values.
+bool LinuxParser::ReadNetDev(std::vector<NetCounters>& interfaces) {
+  thread_local HotFile file;
+  std::size_t count = 0;
+  if (!file.Read(kNetDevFilename)) {
+    interfaces.clear();
+    return false;
+  }
+  const char* cursor = file.content.data();
+  const char* const end = cursor + file.content.size();
+  for (; cursor < end; cursor = lineEnd(cursor, end) + 1) {
+    const char* const eol = lineEnd(cursor, end);
+    const char* colon =
+        static_cast<const char*>(std::memchr(cursor, ':', eol - cursor));
+    if (colon == nullptr) {
+      continue;
+    }
+    const char* name = cursor;
+    while (name < colon && *name == ' ') {
+      ++name;
+    }
+    unsigned long long values[10] = {};
+    const char* field = colon + 1;
+    int column = 0;
+    for (; column < 10; ++column) {
+      while (field < eol && *field == ' ') {
+        ++field;
+      }
+      if (field == eol) {
+        break;
+      }
+      field = std::from_chars(field, eol, values[column]).ptr;
+    }
+    if (column < 10 || name == colon) {
+      continue;
+    }
+    if (count == interfaces.size()) {
+      interfaces.emplace_back();
+    }
+    NetCounters& interface = interfaces[count++];
+    interface.name.assign(name, colon);
+    interface.receiveBytes = values[0];
+    interface.receivePackets = values[1];
+    interface.transmitBytes = values[8];
+    interface.transmitPackets = values[9];
+  }
+  interfaces.resize(count);
+  return true;
+}
+
+// read_bytes and write_bytes are what reached the storage layer, rchar and
+// wchar would count pipes and sockets as well
+bool LinuxParser::ReadIo(int pid, IoCounters& io) {
+  io = {};
+  char buffer[512];
+  const ssize_t length =
+      readPidFile(pid, kIoFile, kIoFilename, buffer, sizeof(buffer));
+  if (length <= 0) {
+    return false;
+  }
+  const char* const end = buffer + length;
+  for (const char* line = buffer; line < end;) {
+    const char* eol = lineEnd(line, end);
+    if (const char* value = fieldValue(line, eol, filterReadBytes)) {
+      std::from_chars(value, eol, io.readBytes);
+    } else if ((value = fieldValue(line, eol, filterWriteBytes))) {
+      std::from_chars(value, eol, io.writeBytes);
+      break;
+    }
+    line = eol + 1;
+  }
+  return true;
+}
+
+// The arguments in cmdline are NUL terminated. The file is read until EOF
+// into command, which grows as needed and keeps its capacity. Trailing NULs
+// are dropped, also the padding left by processes that rewrite their argv.
+bool LinuxParser::ReadCommand(int pid, std::string& command) {
+  command.clear();
+  char path[256];
+  if (!pidPath(path, sizeof(path), pid, kCmdlineFilename)) {
+    return false;
+  }
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return false;
+  }
+  std::size_t length = 0;
+  while (true) {
+    if (length == command.size()) {
+      command.resize(std::max<std::size_t>(4096, 2 * command.size()));
+    }
+    const ssize_t got = read(fd, &command[length], command.size() - length);
+    if (got > 0) {
+      length += got;
+    } else if (got == 0) {
+      break;
+    } else if (errno != EINTR) {
+      close(fd);
+      command.clear();
+      return false;
+    }
+  }
+  close(fd);
+  while (length > 0 && command[length - 1] == '\0') {
+    --length;
+  }
+  command.resize(length);
+  return true;
+}
+
+bool LinuxParser::ReadExe(int pid, std::string& exe) {
+  exe.clear();
+  char path[256];
+  char target[4096];
+  if (!pidPath(path, sizeof(path), pid, kExeFilename)) {
+    return false;
+  }
+  const ssize_t length = readlink(path, target, sizeof(target));
+  if (length <= 0 || static_cast<std::size_t>(length) == sizeof(target)) {
+    return false;
   }
-  return starttime;
+  exe.assign(target, length);
+  return true;
 }
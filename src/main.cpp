@@ -1,7 +1,101 @@
+#include <sys/resource.h>
+
+#include <cstdio>
+#include <string>
+
+#include "batch.h"
+#include "exporter.h"
 #include "ncurses_display.h"
+#include "options.h"
+#include "profiler.h"
+#include "recording.h"
+#include "replay_system.h"
 #include "system.h"
 
-int main() {
-  System system;
-  NCursesDisplay::Display(system);
-}
\ No newline at end of file
+namespace {
+// Print the Profiler table for --profile
+void report(const Options& options) {
+  if (!options.profile) {
+    return;
+  }
+  if (!Profiler::Enabled()) {
+    std::fputs("profiling was disabled at build time\n", stderr);
+    return;
+  }
+  std::fputs(Profiler::Report().c_str(), stderr);
+}
+
+// Raise the soft descriptor limit to the hard one, so that the per-pid file
+// cache can keep the files of more processes open
+void raiseFileLimit() {
+  rlimit limit{};
+  if (getrlimit(RLIMIT_NOFILE, &limit) == 0 &&
+      limit.rlim_cur < limit.rlim_max) {
+    limit.rlim_cur = limit.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &limit);
+  }
+}
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  raiseFileLimit();
+  Options options;
+  std::string error;
+  if (!ParseOptions(argc, argv, options, error)) {
+    if (!error.empty()) {
+      std::fprintf(stderr, "%s\n", error.c_str());
+    }
+    std::fputs(Usage(argv[0]).c_str(), stderr);
+    return error.empty() ? 0 : 2;
+  }
+
+  if (!options.dump.empty()) {
+    return Batch::Dump(options);
+  }
+
+  if (!options.replay.empty()) {
+    ReplaySystem replay;
+    if (!replay.Open(options.replay, error)) {
+      std::fprintf(stderr, "%s\n", error.c_str());
+      return 1;
+    }
+    replay.SortBy(options.sort);
+    NCursesDisplay::Replay(replay, options);
+    report(options);
+    return 0;
+  }
+
+  System system(options.threads);
+  system.Enable(options.collectors);
+  system.SortBy(options.sort);
+  system.SelectThreads(options.threadSelection);
+  system.SelectIo(options.io);
+  system.ShowCgroups(options.cgroups);
+  system.ScheduleReads(options.tiered, options.budget);
+
+  Recording::Writer recorder;
+  if (!options.record.empty()) {
+    // The slots are sized for the cores of this machine
+    system.Refresh();
+    if (!recorder.Open(options.record, options.recordSlots,
+                       system.Cpu().CoreUtilization().size(), options.top,
+                       error)) {
+      std::fprintf(stderr, "%s\n", error.c_str());
+      return 1;
+    }
+  }
+  Recording::Writer* history = options.record.empty() ? nullptr : &recorder;
+
+  if (options.exporter) {
+    int const status = Exporter::Run(system, options, history);
+    report(options);
+    return status;
+  }
+  if (options.batch) {
+    int const status = Batch::Run(system, options, history);
+    report(options);
+    return status;
+  }
+  NCursesDisplay::Display(system, options, history);
+  report(options);
+}
@@ -0,0 +1,78 @@
+#include "metadata_cache.h"
+
+MetadataCache::MetadataCache(StringArena& strings) : strings_(&strings) {}
+
+void MetadataCache::Track(const std::vector<int>& pids) {
+  next_.resize(pids.size());
+  std::size_t previous = 0;
+  for (std::size_t i = 0; i < pids.size(); ++i) {
+    while (previous < entries_.size() && entries_[previous].pid < pids[i]) {
+      Release(entries_[previous++]);
+    }
+    if (previous < entries_.size() && entries_[previous].pid == pids[i]) {
+      next_[i] = entries_[previous++];
+    } else {
+      next_[i] = Entry{};
+      next_[i].pid = pids[i];
+    }
+  }
+  while (previous < entries_.size()) {
+    Release(entries_[previous++]);
+  }
+  entries_.swap(next_);
+}
+
+bool MetadataCache::Current(std::size_t i,
+                            unsigned long long starttime) const {
+  return entries_[i].cached && entries_[i].starttime == starttime;
+}
+
+// A process without argv (a kernel thread, or one that cleared it) shows
+// its executable instead
+void MetadataCache::Store(std::size_t i,
+                          const LinuxParser::ProcessSnapshot& snapshot,
+                          std::string_view user) {
+  Entry& entry = entries_[i];
+  // Interned before the old strings are released, a reused pid often runs
+  // the same command again
+  const Entry previous = entry;
+  entry.starttime = snapshot.stat.starttime;
+  entry.uid = snapshot.uid;
+  entry.command = strings_->Intern(
+      snapshot.command.empty() ? snapshot.exe : snapshot.command);
+  entry.exe = strings_->Intern(snapshot.exe);
+  entry.user = strings_->Intern(user);
+  entry.cached = true;
+  Release(previous);
+}
+
+std::string_view MetadataCache::Command(std::size_t i) const {
+  return strings_->View(entries_[i].command);
+}
+
+std::string_view MetadataCache::Exe(std::size_t i) const {
+  return strings_->View(entries_[i].exe);
+}
+
+std::string_view MetadataCache::User(std::size_t i) const {
+  return strings_->View(entries_[i].user);
+}
+
+StringArena::Id MetadataCache::CommandId(std::size_t i) const {
+  return entries_[i].command;
+}
+
+StringArena::Id MetadataCache::UserId(std::size_t i) const {
+  return entries_[i].user;
+}
+
+int MetadataCache::Uid(std::size_t i) const { return entries_[i].uid; }
+
+void MetadataCache::Release(const Entry& entry) {
+  if (!entry.cached) {
+    return;
+  }
+  strings_->Release(entry.command);
+  strings_->Release(entry.exe);
+  strings_->Release(entry.user);
+}
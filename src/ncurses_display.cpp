@@ -2,111 +2,690 @@
 
 #include <curses.h>
 
+#include <algorithm>
+#include <charconv>
 #include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <iterator>
+#include <memory>
 #include <string>
-#include <thread>
+#include <string_view>
 #include <vector>
 
+#include "canvas.h"
 #include "format.h"
+#include "options.h"
+#include "profiler.h"
+#include "sample.h"
+#include "sample_loop.h"
+#include "sampler.h"
 #include "system.h"
 
-using std::string;
-using std::to_string;
+namespace {
+int const core_column{10};
+// One character per core, from idle to saturated
+char const heat[] = "_.:-=+*#%@";
+
+// Columns available for the per core heat strip in a window of width
+int CoreStripWidth(int width) { return std::max(1, width - core_column - 2); }
+
+// Rows the heat strip needs for cores in a window of width
+int CoreStripRows(std::size_t cores, int width) {
+  int const strip_width = CoreStripWidth(width);
+  return std::max<int>(1, (cores + strip_width - 1) / strip_width);
+}
+
+// Format value into buffer, returns the text
+template <typename TValue>
+std::string_view Number(char (&buffer)[24], TValue value) {
+  auto const result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+  return {buffer, std::size_t(result.ptr - buffer)};
+}
+
+// Format a CPU share as percent in about four characters: "5.25", "12.3"
+// or "100"
+std::string_view Percent(char (&buffer)[24], float share) {
+  float const percent = share * 100;
+  int const precision = percent < 10 ? 2 : percent < 100 ? 1 : 0;
+  auto const result = std::to_chars(buffer, buffer + sizeof(buffer), percent,
+                                    std::chars_format::fixed, precision);
+  return {buffer, std::size_t(result.ptr - buffer)};
+}
+
+// Commands are kept whole, the list shows this much of them plus "..."
+std::size_t const max_command_length{50};
+
+// Draw command at row, column, cut to max_command_length. The NULs between
+// its arguments are shown as spaces.
+void PutCommand(Canvas& canvas, int row, int column,
+                std::string_view command, chtype attributes = A_NORMAL) {
+  for (char const c : command.substr(0, max_command_length)) {
+    column = canvas.Put(
+        row, column,
+        static_cast<unsigned char>(c == '\0' ? ' ' : c) | attributes);
+  }
+  if (command.size() > max_command_length) {
+    canvas.Put(row, column, "...", attributes);
+  }
+}
+}  // namespace
 
 // 50 bars uniformly displayed from 0 - 100 %
 // 2% is one bar(|)
-std::string NCursesDisplay::ProgressBar(float percent) {
-  std::string result{"0%"};
-  int size{50};
-  float bars{percent * size};
-
+void NCursesDisplay::ProgressBar(float percent,
+                                 char (&buffer)[kProgressBarSize]) {
+  int const size{50};
+  float const bars{percent * size};
+  char* out = buffer;
+  *out++ = '0';
+  *out++ = '%';
   for (int i{0}; i < size; ++i) {
-    result += i <= bars ? '|' : ' ';
+    *out++ = i <= bars ? '|' : ' ';
   }
+  *out++ = ' ';
 
-  string display{to_string(percent * 100).substr(0, 4)};
-  if (percent < 0.1 || percent == 1.0)
-    display = " " + to_string(percent * 100).substr(0, 3);
-  return result + " " + display + "/100%";
+  // Four characters, truncated to one decimal: "45.6", " 5.1" or " 100"
+  int const tenths = std::clamp(int(percent * 1000), 0, 1000);
+  if (tenths == 1000) {
+    out = std::copy_n(" 100", 4, out);
+  } else {
+    if (tenths < 100) {
+      *out++ = ' ';
+    }
+    out = std::to_chars(out, buffer + kProgressBarSize, tenths / 10).ptr;
+    *out++ = '.';
+    *out++ = '0' + tenths % 10;
+  }
+  std::copy_n("/100%", 5, out);
 }
 
-void NCursesDisplay::DisplaySystem(System& system, WINDOW* window) {
+void NCursesDisplay::DisplaySystem(const Sample& sample, std::string_view os,
+                                   std::string_view kernel, Canvas& canvas) {
+  char number[24];
+  char bar[kProgressBarSize];
+  char time[Format::kElapsedTimeSize];
   int row{0};
-  mvwprintw(window, ++row, 2, ("OS: " + system.OperatingSystem()).c_str());
-  mvwprintw(window, ++row, 2, ("Kernel: " + system.Kernel()).c_str());
-  mvwprintw(window, ++row, 2, "CPU: ");
-  wattron(window, COLOR_PAIR(1));
-  mvwprintw(window, row, 10, "");
-  wprintw(window, ProgressBar(system.Cpu().Utilization()).c_str());
-  wattroff(window, COLOR_PAIR(1));
-  mvwprintw(window, ++row, 2, "Memory: ");
-  wattron(window, COLOR_PAIR(1));
-  mvwprintw(window, row, 10, "");
-  wprintw(window, ProgressBar(system.MemoryUtilization()).c_str());
-  wattroff(window, COLOR_PAIR(1));
-  mvwprintw(window, ++row, 2,
-            ("Total Processes: " + to_string(system.TotalProcesses())).c_str());
-  mvwprintw(
-      window, ++row, 2,
-      ("Running Processes: " + to_string(system.RunningProcesses())).c_str());
-  mvwprintw(window, ++row, 2,
-            ("Up Time: " + Format::ElapsedTime(system.UpTime())).c_str());
-  wrefresh(window);
-}
-
-void NCursesDisplay::DisplayProcesses(std::vector<Process>& processes,
-                                      WINDOW* window, int n) {
+  int column = canvas.Put(++row, 2, "OS: ");
+  canvas.Put(row, column, os);
+  column = canvas.Put(++row, 2, "Kernel: ");
+  canvas.Put(row, column, kernel);
+  canvas.Put(++row, 2, "CPU: ");
+  ProgressBar(sample.cpu, bar);
+  canvas.Put(row, 10, {bar, sizeof(bar)}, COLOR_PAIR(1));
+  canvas.Put(++row, 2, "Cores: ");
+  std::vector<float> const& cores = sample.cores;
+  int const strip_width = CoreStripWidth(canvas.Columns());
+  for (std::size_t core = 0; core < cores.size(); ++core) {
+    if (core > 0 && core % strip_width == 0) {
+      ++row;
+    }
+    float const utilization = std::clamp(cores[core], 0.0f, 1.0f);
+    int const color = utilization < 0.5f ? 3 : utilization < 0.8f ? 4 : 5;
+    canvas.Put(row, core_column + core % strip_width,
+               heat[std::min(9, int(utilization * 10))] | COLOR_PAIR(color));
+  }
+  canvas.Put(++row, 2, "Memory: ");
+  ProgressBar(sample.memory, bar);
+  canvas.Put(row, 10, {bar, sizeof(bar)}, COLOR_PAIR(1));
+  column = canvas.Put(++row, 2, "Total Processes: ");
+  canvas.Put(row, column, Number(number, sample.totalProcesses));
+  column = canvas.Put(++row, 2, "Running Processes: ");
+  canvas.Put(row, column, Number(number, sample.runningProcesses));
+  column = canvas.Put(++row, 2, "Up Time: ");
+  canvas.Put(row, column, {time, Format::ElapsedTime(sample.uptime, time)});
+}
+
+void NCursesDisplay::DisplayProcesses(const Sample& sample, Canvas& canvas,
+                                      int n, int selected) {
   int row{0};
   int const pid_column{2};
   int const user_column{9};
   int const cpu_column{16};
   int const ram_column{26};
   int const time_column{35};
-  int const command_column{46};
-  wattron(window, COLOR_PAIR(2));
-  mvwprintw(window, ++row, pid_column, "PID");
-  mvwprintw(window, row, user_column, "USER");
-  mvwprintw(window, row, cpu_column, "CPU[%%]");
-  mvwprintw(window, row, ram_column, "RAM[MB]");
-  mvwprintw(window, row, time_column, "TIME+");
-  mvwprintw(window, row, command_column, "COMMAND");
-  wattroff(window, COLOR_PAIR(2));
+  int const io_column{46};
+  int const command_column{56};
+  canvas.Put(++row, pid_column, "PID", COLOR_PAIR(2));
+  canvas.Put(row, user_column, "USER", COLOR_PAIR(2));
+  canvas.Put(row, cpu_column, "CPU[%]", COLOR_PAIR(2));
+  canvas.Put(row, ram_column, "RAM[MB]", COLOR_PAIR(2));
+  canvas.Put(row, time_column, "TIME+", COLOR_PAIR(2));
+  canvas.Put(row, io_column, "IO[KB/s]", COLOR_PAIR(2));
+  canvas.Put(row, command_column, "COMMAND", COLOR_PAIR(2));
+  char number[24];
+  char time[Format::kElapsedTimeSize];
+  std::vector<Process> const& processes = sample.processes;
   int const num_processes = int(processes.size()) > n ? n : processes.size();
-  for (int i = 0; i < num_processes; ++i) {
-    mvwprintw(window, ++row, pid_column, to_string(processes[i].Pid()).c_str());
-    mvwprintw(window, row, user_column, processes[i].User().c_str());
-    float cpu = processes[i].CpuUtilization() * 100;
-    mvwprintw(window, row, cpu_column, to_string(cpu).substr(0, 4).c_str());
-    mvwprintw(window, row, ram_column, processes[i].Ram().c_str());
-    mvwprintw(window, row, time_column,
-              Format::ElapsedTime(processes[i].UpTime()).c_str());
-    mvwprintw(window, row, command_column,
-              processes[i].Command().substr(0, window->_maxx - 46).c_str());
+  for (int i = 0; i < num_processes && row <= n; ++i) {
+    const Process& process = processes[i];
+    chtype const attributes = i == selected ? A_REVERSE : A_NORMAL;
+    ++row;
+    if (i == selected) {
+      for (int column = 1; column < canvas.Columns() - 1; ++column) {
+        canvas.Put(row, column, ' ' | A_REVERSE);
+      }
+    }
+    canvas.Put(row, pid_column, Number(number, process.Pid()), attributes);
+    canvas.Put(row, user_column,
+               std::string_view(process.User())
+                   .substr(0, cpu_column - user_column - 1),
+               attributes);
+    canvas.Put(row, cpu_column, Percent(number, process.CpuUtilization()),
+               attributes);
+    canvas.Put(row, ram_column, Number(number, process.RamMb()), attributes);
+    canvas.Put(row, time_column,
+               {time, Format::ElapsedTime(process.UpTime(), time)},
+               attributes);
+    canvas.Put(
+        row, io_column,
+        Number(number, long((process.ReadRate() + process.WriteRate()) / 1024)),
+        attributes);
+    PutCommand(canvas, row, command_column, process.Command(), attributes);
+    if (process.Pid() != sample.expanded || sample.hotThreads) {
+      continue;
+    }
+    // Threads push the rest of the list down
+    for (ThreadSample const& thread : sample.threads) {
+      if (row > n) {
+        break;
+      }
+      canvas.Put(++row, pid_column + 1, Number(number, thread.tid),
+                 COLOR_PAIR(1));
+      canvas.Put(row, cpu_column, Percent(number, thread.cpu), COLOR_PAIR(1));
+      canvas.Put(row, command_column + 1, thread.name, COLOR_PAIR(1));
+    }
   }
 }
 
-void NCursesDisplay::Display(System& system, int n) {
-  initscr();      // start ncurses
-  noecho();       // do not print input values
-  cbreak();       // terminate ncurses on ctrl + c
-  start_color();  // enable color
+void NCursesDisplay::DisplayThreads(const Sample& sample, Canvas& canvas,
+                                    int n) {
+  int row{0};
+  int const tid_column{2};
+  int const pid_column{9};
+  int const cpu_column{16};
+  int const name_column{26};
+  int const command_column{46};
+  canvas.Put(++row, tid_column, "TID", COLOR_PAIR(2));
+  canvas.Put(row, pid_column, "PID", COLOR_PAIR(2));
+  canvas.Put(row, cpu_column, "CPU[%]", COLOR_PAIR(2));
+  canvas.Put(row, name_column, "THREAD", COLOR_PAIR(2));
+  canvas.Put(row, command_column, "COMMAND", COLOR_PAIR(2));
+  char number[24];
+  int const num_threads =
+      int(sample.threads.size()) > n ? n : sample.threads.size();
+  for (int i = 0; i < num_threads; ++i) {
+    ThreadSample const& thread = sample.threads[i];
+    canvas.Put(++row, tid_column, Number(number, thread.tid));
+    canvas.Put(row, pid_column, Number(number, thread.pid));
+    canvas.Put(row, cpu_column, Percent(number, thread.cpu));
+    canvas.Put(row, name_column,
+               std::string_view(thread.name)
+                   .substr(0, command_column - name_column - 1));
+    PutCommand(canvas, row, command_column, thread.command);
+  }
+}
+
+void NCursesDisplay::DisplayCgroups(const Sample& sample, Canvas& canvas,
+                                    int n) {
+  int row{0};
+  int const cpu_column{2};
+  int const ram_column{11};
+  int const processes_column{20};
+  int const read_column{27};
+  int const write_column{39};
+  int const path_column{51};
+  canvas.Put(++row, cpu_column, "CPU[%]", COLOR_PAIR(2));
+  canvas.Put(row, ram_column, "RAM[MB]", COLOR_PAIR(2));
+  canvas.Put(row, processes_column, "PROCS", COLOR_PAIR(2));
+  canvas.Put(row, read_column, "READ[KB/s]", COLOR_PAIR(2));
+  canvas.Put(row, write_column, "WRITE[KB/s]", COLOR_PAIR(2));
+  canvas.Put(row, path_column, "CGROUP", COLOR_PAIR(2));
+  if (sample.cgroups.empty()) {
+    canvas.Put(++row, path_column, "no cgroup v2 hierarchy found");
+    return;
+  }
+  char number[24];
+  int const num_cgroups =
+      int(sample.cgroups.size()) > n ? n : sample.cgroups.size();
+  for (int i = 0; i < num_cgroups; ++i) {
+    CgroupSample const& cgroup = sample.cgroups[i];
+    canvas.Put(++row, cpu_column, Percent(number, cgroup.cpu));
+    canvas.Put(row, ram_column, Number(number, cgroup.memoryMb));
+    canvas.Put(row, processes_column, Number(number, cgroup.processes));
+    canvas.Put(row, read_column, Number(number, long(cgroup.readRate / 1024)));
+    canvas.Put(row, write_column,
+               Number(number, long(cgroup.writeRate / 1024)));
+    canvas.Put(row, path_column, cgroup.path);
+  }
+}
+
+void NCursesDisplay::DisplayDevices(const Sample& sample, Canvas& canvas,
+                                    int n) {
+  int const disk_column{2};
+  int const read_column{12};
+  int const write_column{22};
+  int const iops_column{32};
+  int const util_column{39};
+  int const interface_column{46};
+  int const receive_column{56};
+  int const transmit_column{66};
+  int row{1};
+  canvas.Put(row, disk_column, "DISK", COLOR_PAIR(2));
+  canvas.Put(row, read_column, "RD[KB/s]", COLOR_PAIR(2));
+  canvas.Put(row, write_column, "WR[KB/s]", COLOR_PAIR(2));
+  canvas.Put(row, iops_column, "IOPS", COLOR_PAIR(2));
+  canvas.Put(row, util_column, "UTIL%", COLOR_PAIR(2));
+  canvas.Put(row, interface_column, "NET", COLOR_PAIR(2));
+  canvas.Put(row, receive_column, "RX[KB/s]", COLOR_PAIR(2));
+  canvas.Put(row, transmit_column, "TX[KB/s]", COLOR_PAIR(2));
+  char number[24];
+  int const num_disks = std::min<int>(n, sample.disks.size());
+  for (int i = 0; i < num_disks; ++i) {
+    DiskSample const& disk = sample.disks[i];
+    canvas.Put(row + 1 + i, disk_column,
+               std::string_view(disk.name)
+                   .substr(0, read_column - disk_column - 1));
+    canvas.Put(row + 1 + i, read_column,
+               Number(number, long(disk.readRate / 1024)));
+    canvas.Put(row + 1 + i, write_column,
+               Number(number, long(disk.writeRate / 1024)));
+    canvas.Put(row + 1 + i, iops_column, Number(number, long(disk.iops)));
+    canvas.Put(row + 1 + i, util_column, Percent(number, disk.utilization));
+  }
+  int const num_interfaces = std::min<int>(n, sample.interfaces.size());
+  for (int i = 0; i < num_interfaces; ++i) {
+    InterfaceSample const& interface = sample.interfaces[i];
+    canvas.Put(row + 1 + i, interface_column,
+               std::string_view(interface.name)
+                   .substr(0, receive_column - interface_column - 1));
+    canvas.Put(row + 1 + i, receive_column,
+               Number(number, long(interface.receiveRate / 1024)));
+    canvas.Put(row + 1 + i, transmit_column,
+               Number(number, long(interface.transmitRate / 1024)));
+  }
+}
+
+namespace {
+// Devices the device panel lists of each kind
+int const device_rows{3};
+// Playback speeds the + and - keys step through
+double const speeds[] = {1, 2, 5, 10, 20, 50, 100};
+// Sampling intervals in milliseconds the + and - keys step through
+long const intervals[] = {100, 200, 500, 1000, 2000, 5000, 10000, 60000};
+
+// Show the playback position and state in the top border of canvas
+void DisplayReplayStatus(ReplaySystem const& replay, Canvas& canvas) {
+  std::time_t const seconds = replay.Timestamp() / 1000;
+  std::tm local{};
+  localtime_r(&seconds, &local);
+  char time[32];
+  std::size_t const length =
+      std::strftime(time, sizeof(time), " %Y-%m-%d %H:%M:%S  ", &local);
+  char speed[24];
+  int column = canvas.Put(0, 2, {time, length});
+  column = canvas.Put(0, column, Number(speed, replay.Speed()));
+  canvas.Put(0, column, replay.Paused() ? "x  paused " : "x ");
+}
+
+// Show how long the previous frame took to draw and how many cells it sent
+// in the bottom border of canvas
+void DisplayFrameStats(std::chrono::microseconds frame, std::size_t cells,
+                       Canvas& canvas) {
+  char number[24];
+  int const row = canvas.Rows() - 1;
+  int column = canvas.Put(row, 2, " frame ");
+  column = canvas.Put(row, column, Number(number, frame.count()));
+  column = canvas.Put(row, column, " us, ");
+  column = canvas.Put(row, column, Number(number, cells));
+  canvas.Put(row, column, " cells ");
+}
+
+// Apply a replay control key. Returns whether the screen needs a redraw.
+bool HandleReplayKey(ReplaySystem& replay, int key) {
+  using std::chrono::hours;
+  using std::chrono::minutes;
+  switch (key) {
+    case ' ':
+      replay.TogglePause();
+      return true;
+    case '+':
+    case '=': {
+      auto faster = std::upper_bound(std::begin(speeds), std::end(speeds),
+                                     replay.Speed());
+      replay.SetSpeed(faster == std::end(speeds) ? speeds[6] : *faster);
+      return true;
+    }
+    case '-': {
+      auto slower = std::lower_bound(std::begin(speeds), std::end(speeds),
+                                     replay.Speed());
+      replay.SetSpeed(slower == std::begin(speeds) ? speeds[0]
+                                                   : *std::prev(slower));
+      return true;
+    }
+    case KEY_LEFT:
+      replay.Seek(-minutes(1));
+      return true;
+    case KEY_RIGHT:
+      replay.Seek(minutes(1));
+      return true;
+    case KEY_PPAGE:
+      replay.Seek(-hours(1));
+      return true;
+    case KEY_NPAGE:
+      replay.Seek(hours(1));
+      return true;
+    case KEY_HOME:
+      replay.SeekTo(replay.Begin());
+      return true;
+    case KEY_END:
+      replay.SeekTo(replay.End());
+      return true;
+  }
+  return false;
+}
+
+// Apply a sort key. Returns false for other keys.
+bool SortKey(int key, System::SortColumn& column) {
+  switch (key) {
+    case 'c':
+      column = System::SortColumn::kCpu;
+      return true;
+    case 'm':
+      column = System::SortColumn::kRam;
+      return true;
+    case 't':
+      column = System::SortColumn::kTime;
+      return true;
+    case 'i':
+      column = System::SortColumn::kIo;
+      return true;
+  }
+  return false;
+}
+
+// Apply a key changing the sampling interval. Returns false for other keys.
+bool IntervalKey(int key, Sampler& sampler) {
+  long const current = sampler.Interval().count();
+  long interval;
+  if (key == '+' || key == '=') {
+    auto const shorter = std::lower_bound(std::begin(intervals),
+                                          std::end(intervals), current);
+    interval = shorter == std::begin(intervals) ? intervals[0]
+                                                : *std::prev(shorter);
+  } else if (key == '-') {
+    auto const longer = std::upper_bound(std::begin(intervals),
+                                         std::end(intervals), current);
+    interval = longer == std::end(intervals) ? *std::prev(longer) : *longer;
+  } else {
+    return false;
+  }
+  sampler.SetInterval(std::chrono::milliseconds(interval));
+  return true;
+}
+
+// Apply a key of the thread view to selection, with selected the row of
+// the process list that is highlighted. Returns false for other keys.
+bool ThreadKey(int key, Sample const& sample, int& selected,
+               System::ThreadSelection& selection) {
+  int const count = sample.processes.size();
+  switch (key) {
+    case KEY_UP:
+      selected = std::clamp(selected - 1, 0, std::max(0, count - 1));
+      return true;
+    case KEY_DOWN:
+      selected = std::clamp(selected + 1, 0, std::max(0, count - 1));
+      return true;
+    case '\n':
+    case KEY_ENTER:
+      if (selected >= 0 && selected < count) {
+        int const pid = sample.processes[selected].Pid();
+        selection.expanded = selection.expanded == pid ? 0 : pid;
+      }
+      return true;
+    case 'h':
+      selection.hot = !selection.hot;
+      return true;
+  }
+  return false;
+}
+
+// Show the sort column, when sampling live the interval, and the view:
+// cgroups or the thread threshold of the hot thread view, in the top border
+// of canvas
+void DisplayControls(System::SortColumn column, Sampler const* sampler,
+                     System::ThreadSelection const& selection,
+                     bool cgroups, Canvas& canvas) {
+  char const* const names[] = {" sort: cpu ", " sort: ram ",
+                               cgroups ? " sort: procs " : " sort: time ",
+                               " sort: io "};
+  int column_end = canvas.Put(0, 2, names[static_cast<int>(column)]);
+  if (sampler != nullptr) {
+    char number[24];
+    column_end = canvas.Put(0, column_end, " every ");
+    column_end =
+        canvas.Put(0, column_end, Number(number, sampler->Interval().count()));
+    column_end = canvas.Put(0, column_end, " ms ");
+  }
+  if (cgroups) {
+    canvas.Put(0, column_end, " cgroups ");
+  } else if (selection.hot) {
+    char number[24];
+    column_end = canvas.Put(0, column_end, " threads of ");
+    if (selection.all) {
+      canvas.Put(0, column_end, "all processes ");
+    } else {
+      column_end = canvas.Put(0, column_end, "processes >= ");
+      column_end =
+          canvas.Put(0, column_end, Percent(number, selection.threshold));
+      canvas.Put(0, column_end, "% ");
+    }
+  }
+}
+
+// Draw the profiler table into canvas, see Profiler::FormatRow()
+void DisplayProfile(Canvas& canvas) {
+  canvas.Put(0, 2, " profile ", COLOR_PAIR(2));
+  if (!Profiler::Enabled()) {
+    canvas.Put(1, 2, "profiling was disabled at build time");
+    return;
+  }
+  char row[Profiler::kRowSize];
+  for (int i = 0; i < Profiler::kRows; ++i) {
+    std::size_t const length =
+        std::min(Profiler::FormatRow(i, row, sizeof(row)), sizeof(row) - 1);
+    canvas.Put(i + 1, 2, {row, length}, i == 0 ? COLOR_PAIR(2) : A_NORMAL);
+  }
+}
+
+// Draw the newest sample every render interval until q is pressed or the
+// process is told to stop. Live samples come from a Sampler thread; with
+// replay set, system is that replay and it is advanced on this thread.
+void Run(System& system, const Options& options,
+         Recording::Writer* recorder, ReplaySystem* replay) {
+  int const n = options.top;
+  // A signal also ends the wait for a key
+  SampleLoop::CatchStopSignals();
+
+  initscr();             // start ncurses
+  noecho();              // do not print input values
+  cbreak();              // keys arrive without waiting for return
+  keypad(stdscr, TRUE);  // deliver arrow and page keys as KEY_*
+  curs_set(0);           // hide the cursor
+  start_color();         // enable color
+
+  // Paint the blank screen once, later frames only send what changed
+  refresh();
+  init_pair(1, COLOR_BLUE, COLOR_BLACK);
+  init_pair(2, COLOR_GREEN, COLOR_BLACK);
+  init_pair(3, COLOR_GREEN, COLOR_BLACK);
+  init_pair(4, COLOR_YELLOW, COLOR_BLACK);
+  init_pair(5, COLOR_RED, COLOR_BLACK);
 
   int x_max{getmaxx(stdscr)};
-  WINDOW* system_window = newwin(9, x_max - 1, 0, 0);
-  WINDOW* process_window =
-      newwin(3 + n, x_max - 1, system_window->_maxy + 1, 0);
-
-  while (1) {
-    init_pair(1, COLOR_BLUE, COLOR_BLACK);
-    init_pair(2, COLOR_GREEN, COLOR_BLACK);
-    box(system_window, 0, 0);
-    box(process_window, 0, 0);
-    DisplaySystem(system, system_window);
-    DisplayProcesses(system.Processes(), process_window, n);
-    wrefresh(system_window);
-    wrefresh(process_window);
-    refresh();
-    std::this_thread::sleep_for(std::chrono::seconds(1));
+  // Take a first sample to learn the number of cores. System belongs to
+  // the sampler thread once that runs.
+  system.Refresh();
+  int const core_rows =
+      CoreStripRows(system.Cpu().CoreUtilization().size(), x_max - 1);
+  int const system_rows = 9 + core_rows;
+  int const devices_rows = 3 + device_rows;
+  Canvas system_canvas(newwin(system_rows, x_max - 1, 0, 0));
+  Canvas devices_canvas(newwin(devices_rows, x_max - 1, system_rows, 0));
+  Canvas process_canvas(
+      newwin(3 + n, x_max - 1, system_rows + devices_rows, 0));
+  // Debug panel, over the bottom of the process window if the screen ends
+  // there
+  int const profile_rows = std::min(Profiler::kRows + 2, LINES);
+  int const profile_columns =
+      std::min<int>(Profiler::kRowSize + 4, std::max(1, x_max - 1));
+  Canvas profile_canvas(
+      newwin(profile_rows, profile_columns,
+             std::max(0, std::min(system_rows + devices_rows + 3 + n,
+                                  LINES - profile_rows)),
+             0));
+  bool show_profile{false};
+  std::string const os = system.OperatingSystem();
+  std::string const kernel = system.Kernel();
+  System::SortColumn sort_column = system.SortedBy();
+  System::ThreadSelection thread_selection = system.SelectedThreads();
+  int selected{0};
+  bool show_cgroups = system.ShowingCgroups();
+
+  std::unique_ptr<Sampler> sampler;
+  if (replay == nullptr) {
+    sampler = std::make_unique<Sampler>(system, n, options.interval, recorder);
   }
+  Sample replay_sample;
+  Sample const* sample{nullptr};
+
+  std::chrono::microseconds frame{0};
+  std::size_t cells{0};
+  bool redraw{true};
+  bool quit{false};
+  auto next = std::chrono::steady_clock::now();
+  while (!quit && !SampleLoop::StopRequested()) {
+    if (replay != nullptr) {
+      replay->Refresh();
+      replay->Processes();
+      replay->Capture(replay_sample, n);
+      replay_sample.timestamp = replay->Timestamp();
+      sample = &replay_sample;
+      redraw = true;
+    } else if (Sample const* latest = sampler->Latest()) {
+      sample = latest;
+      redraw = true;
+    }
+
+    // Nothing new, nothing to draw
+    if (redraw && sample != nullptr) {
+      PROFILE_SCOPE(kRender);
+      auto const start = std::chrono::steady_clock::now();
+      system_canvas.Clear();
+      system_canvas.Box();
+      NCursesDisplay::DisplaySystem(*sample, os, kernel, system_canvas);
+      if (replay != nullptr) {
+        DisplayReplayStatus(*replay, system_canvas);
+      }
+      devices_canvas.Clear();
+      devices_canvas.Box();
+      NCursesDisplay::DisplayDevices(*sample, devices_canvas, device_rows);
+      process_canvas.Clear();
+      process_canvas.Box();
+      if (sample->cgroupView) {
+        NCursesDisplay::DisplayCgroups(*sample, process_canvas, n);
+      } else if (sample->hotThreads) {
+        NCursesDisplay::DisplayThreads(*sample, process_canvas, n);
+      } else {
+        selected = std::min<int>(selected, sample->processes.size() - 1);
+        NCursesDisplay::DisplayProcesses(*sample, process_canvas, n,
+                                         replay != nullptr ? -1 : selected);
+      }
+      DisplayControls(sort_column, sampler.get(), thread_selection,
+                      sample->cgroupView, process_canvas);
+      DisplayFrameStats(frame, cells, process_canvas);
+      cells = system_canvas.Flush() + devices_canvas.Flush() +
+              process_canvas.Flush();
+      if (show_profile) {
+        // Sent in full, the process window may have drawn over it
+        profile_canvas.Clear();
+        profile_canvas.Box();
+        DisplayProfile(profile_canvas);
+        profile_canvas.Invalidate();
+        cells += profile_canvas.Flush();
+      }
+      if (cells > 0) {
+        doupdate();
+      }
+      frame = std::chrono::duration_cast<std::chrono::microseconds>(
+          std::chrono::steady_clock::now() - start);
+    }
+    // Without a sample yet there is nothing to redraw, the first one
+    // triggers the frame
+    redraw = false;
+
+    // Wait for the next frame, a key that changes the view draws right away
+    next += options.renderInterval;
+    auto now = std::chrono::steady_clock::now();
+    if (next < now) {
+      next = now;
+    }
+    while (!quit && !redraw && !SampleLoop::StopRequested() &&
+           now < next) {
+      timeout(std::chrono::duration_cast<std::chrono::milliseconds>(next - now)
+                  .count() +
+              1);
+      int const key = getch();
+      if (key == 'q') {
+        quit = true;
+      } else if (key == 'd') {
+        show_profile = !show_profile;
+        if (!show_profile) {
+          // Uncover what the panel hid
+          touchwin(stdscr);
+          wnoutrefresh(stdscr);
+          system_canvas.Invalidate();
+          devices_canvas.Invalidate();
+          process_canvas.Invalidate();
+        }
+        redraw = true;
+      } else if (SortKey(key, sort_column)) {
+        if (replay != nullptr) {
+          replay->SortBy(sort_column);
+        } else {
+          sampler->SortBy(sort_column);
+        }
+        redraw = true;
+      } else if (replay != nullptr) {
+        redraw = HandleReplayKey(*replay, key);
+      } else if (key == 'g') {
+        show_cgroups = !show_cgroups;
+        sampler->ShowCgroups(show_cgroups);
+        redraw = true;
+      } else if (sample != nullptr &&
+                 ThreadKey(key, *sample, selected, thread_selection)) {
+        // Moving the selection only needs a redraw
+        if (key != KEY_UP && key != KEY_DOWN) {
+          sampler->SelectThreads(thread_selection);
+        }
+        redraw = true;
+      } else {
+        redraw = IntervalKey(key, *sampler);
+      }
+      now = std::chrono::steady_clock::now();
+    }
+  }
+  // Join the sampler before the terminal is restored
+  sampler.reset();
   endwin();
 }
+}  // namespace
+
+void NCursesDisplay::Display(System& system, const Options& options,
+                             Recording::Writer* recorder) {
+  Run(system, options, recorder, nullptr);
+}
+
+void NCursesDisplay::Replay(ReplaySystem& system, const Options& options) {
+  Run(system, options, nullptr, &system);
+}
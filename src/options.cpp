@@ -0,0 +1,179 @@
+#include "options.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace {
+// Parse value as a number within [min, max]
+template <typename TValue>
+bool parseNumber(const char* value, TValue min, TValue max, TValue& result) {
+  const char* end = value + std::strlen(value);
+  TValue parsed{};
+  auto [last, error] = std::from_chars(value, end, parsed);
+  if (error != std::errc() || last != end || parsed < min || parsed > max) {
+    return false;
+  }
+  result = parsed;
+  return true;
+}
+
+// Parse a comma separated list of pids
+bool parsePids(const char* value, std::vector<int>& pids) {
+  pids.clear();
+  const char* const end = value + std::strlen(value);
+  for (const char* cursor = value; cursor <= end; ++cursor) {
+    int pid{0};
+    auto [last, error] = std::from_chars(cursor, end, pid);
+    if (error != std::errc() || pid < 1 || (last != end && *last != ',')) {
+      return false;
+    }
+    pids.emplace_back(pid);
+    cursor = last;
+  }
+  return true;
+}
+}  // namespace
+
+bool ParseOptions(int argc, char* argv[], Options& options,
+                  std::string& error) {
+  for (int i = 1; i < argc; ++i) {
+    const std::string flag{argv[i]};
+    if (flag == "-h" || flag == "--help") {
+      error.clear();
+      return false;
+    }
+    if (flag == "--batch") {
+      options.batch = true;
+      continue;
+    }
+    if (flag == "--profile") {
+      options.profile = true;
+      continue;
+    }
+    if (flag == "--hot-threads") {
+      options.threadSelection.hot = true;
+      continue;
+    }
+    if (flag == "--all-threads") {
+      options.threadSelection.all = true;
+      continue;
+    }
+    if (flag == "--cgroups") {
+      options.cgroups = true;
+      continue;
+    }
+    if (flag == "--tiered") {
+      options.tiered = true;
+      continue;
+    }
+
+    static const std::string valued[] = {
+        "--top",           "--threads",      "--sort",
+        "--interval",      "--iterations",   "--format",
+        "--output",        "--record",       "--record-slots",
+        "--dump",          "--replay",       "--render-interval",
+        "--thread-threshold", "--budget",    "--budget-us",
+        "--io-top",        "--io-watch",     "--collectors",
+        "--export"};
+    if (std::find(std::begin(valued), std::end(valued), flag) ==
+        std::end(valued)) {
+      error = "unknown option " + flag;
+      return false;
+    }
+    if (i + 1 >= argc) {
+      error = "missing value for " + flag;
+      return false;
+    }
+    const char* value = argv[++i];
+    bool valid = true;
+    if (flag == "--top") {
+      valid = parseNumber(value, 1, 100000, options.top);
+    } else if (flag == "--threads") {
+      valid = parseNumber<std::size_t>(value, 0, 4096, options.threads);
+    } else if (flag == "--sort") {
+      const std::string column{value};
+      if (column == "cpu") {
+        options.sort = System::SortColumn::kCpu;
+      } else if (column == "ram") {
+        options.sort = System::SortColumn::kRam;
+      } else if (column == "time") {
+        options.sort = System::SortColumn::kTime;
+      } else if (column == "io") {
+        options.sort = System::SortColumn::kIo;
+      } else {
+        valid = false;
+      }
+    } else if (flag == "--interval") {
+      long milliseconds{0};
+      valid = parseNumber(value, 1L, 86400000L, milliseconds);
+      options.interval = std::chrono::milliseconds(milliseconds);
+    } else if (flag == "--render-interval") {
+      long milliseconds{0};
+      valid = parseNumber(value, 1L, 60000L, milliseconds);
+      options.renderInterval = std::chrono::milliseconds(milliseconds);
+    } else if (flag == "--thread-threshold") {
+      float percent{0};
+      valid = parseNumber(value, 0.0f, 100000.0f, percent);
+      options.threadSelection.threshold = percent / 100;
+    } else if (flag == "--budget") {
+      valid = parseNumber<std::size_t>(value, 1, 100000000,
+                                       options.budget.syscalls);
+    } else if (flag == "--budget-us") {
+      long microseconds{0};
+      valid = parseNumber(value, 1L, 60000000L, microseconds);
+      options.budget.time = std::chrono::microseconds(microseconds);
+    } else if (flag == "--io-top") {
+      valid = parseNumber<std::size_t>(value, 0, 100000, options.io.top);
+    } else if (flag == "--io-watch") {
+      valid = parsePids(value, options.io.watched);
+    } else if (flag == "--collectors") {
+      if (!Collectors::Parse(value, options.collectors, error)) {
+        return false;
+      }
+    } else if (flag == "--export") {
+      options.exporter = true;
+      valid = Exporter::ParseAddress(value, options.exportTo);
+    } else if (flag == "--iterations") {
+      valid = parseNumber(value, 0L, 1L << 62, options.iterations);
+    } else if (flag == "--format") {
+      valid = Batch::ParseFormat(value, options.format);
+    } else if (flag == "--output") {
+      options.output = value;
+    } else if (flag == "--replay") {
+      options.replay = value;
+    } else if (flag == "--dump") {
+      options.dump = value;
+    } else if (flag == "--record") {
+      options.record = value;
+    } else if (flag == "--record-slots") {
+      valid = parseNumber<std::uint32_t>(value, 1, 10000000,
+                                         options.recordSlots);
+    }
+    if (!valid) {
+      error = "invalid value for " + flag + ": " + value;
+      return false;
+    }
+  }
+  return true;
+}
+
+std::string Usage(const std::string& program) {
+  return "usage: " + program +
+         " [--top N] [--threads N] [--sort cpu|ram|time|io]\n"
+         "       [--interval MS] [--render-interval MS] [--profile]\n"
+         "       [--hot-threads] [--thread-threshold PCT] [--all-threads]\n"
+         "       [--cgroups] [--tiered] [--budget N] [--budget-us US]\n"
+         "       [--io-top N] [--io-watch PID[,PID...]]\n"
+         "       [--collectors cpu,memory,processes,io,threads,cgroups,"
+         "devices]\n"
+         "       [--record FILE [--record-slots N]]\n"
+         "       [--replay FILE]\n"
+         "       [--dump FILE [--format json|csv|binary] [--output FILE]]\n"
+         "       [--batch [--iterations N]\n"
+         "                [--format json|csv|binary] [--output FILE]]\n"
+         "       [--export PORT|127.0.0.1:PORT|SOCKET]\n";
+}
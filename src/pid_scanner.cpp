@@ -0,0 +1,128 @@
+#include "pid_scanner.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+
+namespace {
+// Record layout of getdents64(), see getdents(2)
+struct LinuxDirent64 {
+  std::uint64_t d_ino;
+  std::int64_t d_off;
+  unsigned short d_reclen;
+  unsigned char d_type;
+  char d_name[];
+};
+
+// Return the pid named by name, or -1 if name is not a positive number
+int parsePid(const char* name) {
+  if (*name < '1' || *name > '9') {
+    return -1;
+  }
+  int pid = 0;
+  for (; *name != '\0'; ++name) {
+    if (*name < '0' || *name > '9' || pid > (0x7fffffff - 9) / 10) {
+      return -1;
+    }
+    pid = pid * 10 + (*name - '0');
+  }
+  return pid;
+}
+}  // namespace
+
+PidScanner::~PidScanner() {
+  if (fd_ >= 0) {
+    close(fd_);
+  }
+}
+
+bool PidScanner::Scan(const std::string& directory) {
+  previous_.swap(pids_);
+  pids_.clear();
+  diffed_ = false;
+  if (fd_ >= 0 && directory != directory_) {
+    close(fd_);
+    fd_ = -1;
+  }
+  if (fd_ < 0) {
+    directory_ = directory;
+    fd_ = open(directory_.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  } else if (lseek(fd_, 0, SEEK_SET) != 0) {
+    close(fd_);
+    fd_ = -1;
+  }
+  if (fd_ < 0) {
+    return false;
+  }
+
+  buffer_.resize(kBufferSize);
+  long length;
+  while ((length = syscall(SYS_getdents64, fd_, buffer_.data(),
+                           buffer_.size())) > 0) {
+    for (long offset = 0; offset < length;) {
+      const auto* entry =
+          reinterpret_cast<const LinuxDirent64*>(buffer_.data() + offset);
+      offset += entry->d_reclen;
+      // Filesystems without d_type report unknown, the pid is then dropped
+      // when its files cannot be read
+      if (entry->d_type != DT_DIR && entry->d_type != DT_UNKNOWN) {
+        continue;
+      }
+      const int pid = parsePid(entry->d_name);
+      if (pid > 0) {
+        pids_.emplace_back(pid);
+      }
+    }
+  }
+  if (length < 0) {
+    // Try a fresh descriptor on the next call.
+    close(fd_);
+    fd_ = -1;
+    pids_.clear();
+    return false;
+  }
+
+  // /proc lists pids in ascending order, other directories need sorting
+  if (!std::is_sorted(pids_.begin(), pids_.end())) {
+    std::sort(pids_.begin(), pids_.end());
+  }
+  return true;
+}
+
+void PidScanner::Reset() {
+  pids_.clear();
+  added_.clear();
+  removed_.clear();
+  diffed_ = true;
+}
+
+const std::vector<int>& PidScanner::Pids() const { return pids_; }
+
+const std::vector<int>& PidScanner::Added() {
+  Diff();
+  return added_;
+}
+
+const std::vector<int>& PidScanner::Removed() {
+  Diff();
+  return removed_;
+}
+
+// Compare the sorted pids of this and the previous scan, once per scan
+void PidScanner::Diff() {
+  if (diffed_) {
+    return;
+  }
+  diffed_ = true;
+  added_.clear();
+  removed_.clear();
+  std::set_difference(pids_.begin(), pids_.end(), previous_.begin(),
+                      previous_.end(), std::back_inserter(added_));
+  std::set_difference(previous_.begin(), previous_.end(), pids_.begin(),
+                      pids_.end(), std::back_inserter(removed_));
+}
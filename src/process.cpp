@@ -1,37 +1,35 @@
 #include "process.h"
 
-#include <unistd.h>
-
 #include <cctype>
 #include <sstream>
 #include <string>
+#include <utility>
 #include <vector>
 
-#include "linux_parser.h"
-
 using namespace std;
 
-Process::Process(int pid) {
+Process::Process(int pid, string user, string command, float cpu, long ramMb,
+                 long uptime, float readRate, float writeRate)
+    : pid_(pid),
+      ram_(ramMb),
+      cpuUtilization_(cpu),
+      uptime_(uptime),
+      readRate_(readRate),
+      writeRate_(writeRate),
+      command_(std::move(command)),
+      user_(std::move(user)) {}
+
+void Process::Assign(int pid, std::string_view user, std::string_view command,
+                     float cpu, long ramMb, long uptime, float readRate,
+                     float writeRate) {
   pid_ = pid;
-  command_ = LinuxParser::Command(pid_);
-  if (command_.length() > MAX_COMMAND_LENGTH) {
-    command_ = command_.substr(0, MAX_COMMAND_LENGTH) + "...";
-  }
-
-  string ram = LinuxParser::Ram(pid_);
-  try {
-    ram_ = stol(ram);
-  } catch (...) {
-    ram_ = 0;
-  }
-
-  uptime_ = LinuxParser::UpTime() - LinuxParser::UpTime(pid_);
-  user_ = LinuxParser::User(pid_);
-
-  double processActivetime = LinuxParser::ActiveJiffies(pid_);
-  if (UpTime() != 0) {
-    cpuUtilization_ = processActivetime / UpTime();
-  }
+  user_.assign(user);
+  command_.assign(command);
+  cpuUtilization_ = cpu;
+  ram_ = ramMb;
+  uptime_ = uptime;
+  readRate_ = readRate;
+  writeRate_ = writeRate;
 }
 
 // Return this process's ID
@@ -41,13 +39,16 @@ int Process::Pid() const { return pid_; }
 float Process::CpuUtilization() const { return cpuUtilization_; }
 
 // Return the command that generated this process
-string Process::Command() const { return command_; }
+const string& Process::Command() const { return command_; }
 
 // Return this process's memory utilization
 string Process::Ram() const { return to_string(ram_); }
 
+// Return this process's memory utilization in MB
+long int Process::RamMb() const { return ram_; }
+
 // Return the user (name) that generated this process
-string Process::User() const { return user_; }
+const string& Process::User() const { return user_; }
 
 // Return the age of this process (in seconds)
 // Due to the latest Udacity Review, the Process Constructor changed. The
@@ -56,6 +57,12 @@ string Process::User() const { return user_; }
 // https://man7.org/linux/man-pages/man5/proc.5.html
 long int Process::UpTime() const { return uptime_; }
 
+// Return the bytes per second this process read from storage
+float Process::ReadRate() const { return readRate_; }
+
+// Return the bytes per second this process wrote to storage
+float Process::WriteRate() const { return writeRate_; }
+
 // Overload the "less than" comparison operator for Process objects
 bool Process::operator<(Process const& a) const {
   return CpuUtilization() < a.CpuUtilization();
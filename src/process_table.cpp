@@ -0,0 +1,228 @@
+#include "process_table.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <numeric>
+
+namespace {
+const long ticks = sysconf(_SC_CLK_TCK);
+}  // namespace
+
+ProcessTable::Row::Row(const ProcessTable& table, std::size_t row)
+    : table_(&table), row_(static_cast<std::uint32_t>(row)) {}
+
+ProcessTable::ProcessTable(StringArena& strings) : strings_(&strings) {}
+
+int ProcessTable::Row::Pid() const { return table_->current_.pid[row_]; }
+
+std::string_view ProcessTable::Row::User() const {
+  return table_->strings_->View(table_->current_.user[row_]);
+}
+
+std::string_view ProcessTable::Row::Command() const {
+  return table_->strings_->View(table_->current_.command[row_]);
+}
+
+float ProcessTable::Row::CpuUtilization() const {
+  return table_->current_.cpu[row_];
+}
+
+std::string ProcessTable::Row::Ram() const { return std::to_string(RamMb()); }
+
+long ProcessTable::Row::RamMb() const { return table_->current_.ramMb[row_]; }
+
+long ProcessTable::Row::UpTime() const {
+  return table_->current_.uptime[row_];
+}
+
+float ProcessTable::Row::ReadRate() const {
+  return table_->current_.readRate[row_];
+}
+
+float ProcessTable::Row::WriteRate() const {
+  return table_->current_.writeRate[row_];
+}
+
+std::size_t ProcessTable::Size() const { return current_.pid.size(); }
+
+ProcessTable::Row ProcessTable::operator[](std::size_t row) const {
+  return Row(*this, row);
+}
+
+std::size_t ProcessTable::Find(int pid) const {
+  auto found =
+      std::lower_bound(current_.pid.begin(), current_.pid.end(), pid);
+  return found != current_.pid.end() && *found == pid
+             ? found - current_.pid.begin()
+             : Size();
+}
+
+const std::vector<int>& ProcessTable::Pids() const { return current_.pid; }
+
+const std::vector<unsigned long long>& ProcessTable::Starttime() const {
+  return current_.starttime;
+}
+
+const std::vector<float>& ProcessTable::Cpu() const { return current_.cpu; }
+
+const std::vector<long>& ProcessTable::RamMb() const {
+  return current_.ramMb;
+}
+
+const std::vector<long>& ProcessTable::UpTime() const {
+  return current_.uptime;
+}
+
+const std::vector<float>& ProcessTable::ReadRate() const {
+  return current_.readRate;
+}
+
+const std::vector<float>& ProcessTable::WriteRate() const {
+  return current_.writeRate;
+}
+
+bool ProcessTable::SameProcess(
+    std::size_t row, const LinuxParser::ProcessSnapshot& snapshot) const {
+  return snapshot.stat.pid == current_.pid[row] &&
+         snapshot.stat.starttime == current_.starttime[row];
+}
+
+void ProcessTable::Begin() { next_.Clear(); }
+
+void ProcessTable::Keep(std::size_t row, long systemUptime) {
+  Copy(row);
+  next_.uptime.back() = systemUptime - current_.starttime[row] / ticks;
+}
+
+void ProcessTable::Update(std::size_t row,
+                          const LinuxParser::ProcessSnapshot& snapshot,
+                          long systemUptime, double elapsedSeconds) {
+  Copy(row);
+  const unsigned long activeJiffies = snapshot.stat.utime + snapshot.stat.stime;
+  if (elapsedSeconds > 0 && activeJiffies >= current_.activeJiffies[row]) {
+    next_.cpu.back() = double(activeJiffies - current_.activeJiffies[row]) /
+                       ticks / elapsedSeconds;
+  }
+  next_.activeJiffies.back() = activeJiffies;
+  next_.ramMb.back() = snapshot.ramKb / 1024;
+  next_.uptime.back() = systemUptime - snapshot.stat.starttime / ticks;
+}
+
+// Without a previous sample the best estimate is the lifetime average
+void ProcessTable::Add(const LinuxParser::ProcessSnapshot& snapshot,
+                       StringArena::Id command, StringArena::Id user,
+                       long systemUptime) {
+  const unsigned long activeJiffies = snapshot.stat.utime + snapshot.stat.stime;
+  const long uptime = systemUptime - snapshot.stat.starttime / ticks;
+  next_.pid.emplace_back(snapshot.stat.pid);
+  next_.starttime.emplace_back(snapshot.stat.starttime);
+  next_.activeJiffies.emplace_back(activeJiffies);
+  next_.cpu.emplace_back(uptime > 0 ? double(activeJiffies) / ticks / uptime
+                                    : 0);
+  next_.ramMb.emplace_back(snapshot.ramKb / 1024);
+  next_.uptime.emplace_back(uptime);
+  strings_->Acquire(command);
+  strings_->Acquire(user);
+  next_.command.emplace_back(command);
+  next_.user.emplace_back(user);
+  AddIo();
+}
+
+void ProcessTable::Drop(std::size_t row) {
+  strings_->Release(current_.command[row]);
+  strings_->Release(current_.user[row]);
+}
+
+void ProcessTable::Commit() { std::swap(current_, next_); }
+
+// Recorded processes are ordered by the sort column, the table by pid
+void ProcessTable::Assign(const std::vector<Process>& processes) {
+  for (std::size_t row = 0; row < Size(); ++row) {
+    Drop(row);
+  }
+  std::vector<std::size_t> order(processes.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+    return processes[a].Pid() < processes[b].Pid();
+  });
+  Begin();
+  for (const std::size_t i : order) {
+    const Process& process = processes[i];
+    next_.pid.emplace_back(process.Pid());
+    next_.starttime.emplace_back(0);
+    next_.activeJiffies.emplace_back(0);
+    next_.cpu.emplace_back(process.CpuUtilization());
+    next_.ramMb.emplace_back(process.RamMb());
+    next_.uptime.emplace_back(process.UpTime());
+    next_.command.emplace_back(strings_->Intern(process.Command()));
+    next_.user.emplace_back(strings_->Intern(process.User()));
+    AddIo();
+    next_.readRate.back() = process.ReadRate();
+    next_.writeRate.back() = process.WriteRate();
+  }
+  Commit();
+}
+
+void ProcessTable::SampleIo(std::size_t row, const LinuxParser::IoCounters& io,
+                            std::chrono::steady_clock::time_point now) {
+  const LinuxParser::IoCounters& then = current_.io[row];
+  double elapsed;
+  if (current_.ioSampled[row] == std::chrono::steady_clock::time_point{}) {
+    elapsed = current_.uptime[row];
+  } else {
+    elapsed = std::chrono::duration<double>(now - current_.ioSampled[row])
+                  .count();
+  }
+  if (elapsed > 0) {
+    current_.readRate[row] =
+        io.readBytes >= then.readBytes
+            ? (io.readBytes - then.readBytes) / elapsed
+            : 0;
+    current_.writeRate[row] =
+        io.writeBytes >= then.writeBytes
+            ? (io.writeBytes - then.writeBytes) / elapsed
+            : 0;
+  }
+  current_.io[row] = io;
+  current_.ioSampled[row] = now;
+}
+
+// The ids move to the next table with the row, no reference is taken
+void ProcessTable::Copy(std::size_t row) {
+  next_.pid.emplace_back(current_.pid[row]);
+  next_.starttime.emplace_back(current_.starttime[row]);
+  next_.activeJiffies.emplace_back(current_.activeJiffies[row]);
+  next_.cpu.emplace_back(current_.cpu[row]);
+  next_.ramMb.emplace_back(current_.ramMb[row]);
+  next_.uptime.emplace_back(current_.uptime[row]);
+  next_.command.emplace_back(current_.command[row]);
+  next_.user.emplace_back(current_.user[row]);
+  next_.io.emplace_back(current_.io[row]);
+  next_.ioSampled.emplace_back(current_.ioSampled[row]);
+  next_.readRate.emplace_back(0);
+  next_.writeRate.emplace_back(0);
+}
+
+// Not sampled yet
+void ProcessTable::AddIo() {
+  next_.io.emplace_back();
+  next_.ioSampled.emplace_back();
+  next_.readRate.emplace_back(0);
+  next_.writeRate.emplace_back(0);
+}
+
+void ProcessTable::Columns::Clear() {
+  pid.clear();
+  starttime.clear();
+  activeJiffies.clear();
+  cpu.clear();
+  ramMb.clear();
+  uptime.clear();
+  command.clear();
+  user.clear();
+  io.clear();
+  ioSampled.clear();
+  readRate.clear();
+  writeRate.clear();
+}
@@ -1,24 +1,64 @@
 #include "processor.h"
 
+#include <cstddef>
+
 #include "linux_parser.h"
 
-// Return the aggregated CPU utilization
-float Processor::Utilization() {
-  long total_new = LinuxParser::Jiffies();
-  long active_new = LinuxParser::ActiveJiffies();
-  long idle_new = LinuxParser::IdleJiffies();
-
-  long total_old = totalTime_;
-  long idle_old = idleTime_;
-  idleTime_ = idle_new;
-  activeTime_ = active_new;
-  totalTime_ = total_new;
-
-  float totalDelta = float(total_new) - float(total_old);
-  float idleDelta = float(idle_new) - float(idle_old);
-  if (totalDelta != 0) {
-    return (totalDelta - idleDelta) / totalDelta;
-  } else {
-    return 0;
+namespace {
+// Share of busy and of stolen time between two samples for n cpus. Straight
+// line code over contiguous arrays, so the compiler turns it into SIMD
+// instructions.
+void Deltas(const LinuxParser::CpuJiffies& current,
+            const LinuxParser::CpuJiffies& previous, float* __restrict busy,
+            float* __restrict steal, std::size_t n) {
+  const double* __restrict total = current.total.data();
+  const double* __restrict idle = current.idle.data();
+  const double* __restrict stolen = current.steal.data();
+  const double* __restrict previousTotal = previous.total.data();
+  const double* __restrict previousIdle = previous.idle.data();
+  const double* __restrict previousStolen = previous.steal.data();
+  for (std::size_t i = 0; i < n; ++i) {
+    const double totalDelta = total[i] - previousTotal[i];
+    const double divisor = totalDelta < 1.0 ? 1.0 : totalDelta;
+    busy[i] = (totalDelta - (idle[i] - previousIdle[i])) / divisor;
+    steal[i] = (stolen[i] - previousStolen[i]) / divisor;
   }
-}
\ No newline at end of file
+}
+}  // namespace
+
+// Compute the utilization since the previous sample
+void Processor::Update(const LinuxParser::CpuJiffies& jiffies) {
+  const std::size_t n = jiffies.total.size();
+  // A core came online or this is the first sample: no usable previous value.
+  if (previous_.total.size() != n) {
+    previous_.total.assign(n, 0);
+    previous_.idle.assign(n, 0);
+    previous_.steal.assign(n, 0);
+  }
+  utilization_.resize(n);
+  steal_.resize(n);
+  Deltas(jiffies, previous_, utilization_.data(), steal_.data(), n);
+  previous_ = jiffies;
+
+  cores_.assign(utilization_.begin() + (n ? 1 : 0), utilization_.end());
+}
+
+// Replace the utilization, steal and per-core values with recorded ones, no
+// jiffies are involved
+void Processor::Assign(float utilization, float steal,
+                       const std::vector<float>& cores) {
+  utilization_.assign(1, utilization);
+  steal_.assign(1, steal);
+  cores_ = cores;
+}
+
+// Return the aggregated CPU utilization
+float Processor::Utilization() const {
+  return utilization_.empty() ? 0 : utilization_[0];
+}
+
+// Return the aggregated steal time share
+float Processor::Steal() const { return steal_.empty() ? 0 : steal_[0]; }
+
+// Return the utilization of every core
+const std::vector<float>& Processor::CoreUtilization() const { return cores_; }
@@ -0,0 +1,200 @@
+#include "profiler.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include "fd_cache.h"
+
+namespace {
+Profiler::Histogram histograms[static_cast<int>(Profiler::Metric::kCount)];
+
+struct Description {
+  const char* name;
+  const char* unit;
+};
+const Description descriptions[] = {
+    {"tick", "ns"},    {"pids", "ns"},    {"parse", "ns"},
+    {"io", "ns"},      {"threads", "ns"}, {"cgroups", "ns"},
+    {"passwd", "ns"},  {"sort", "ns"},    {"render", "ns"},
+    {"allocations", ""}, {"syscalls", ""}, {"reads", ""}};
+static_assert(sizeof(descriptions) / sizeof(descriptions[0]) ==
+                  static_cast<int>(Profiler::Metric::kCount),
+              "every metric needs a description");
+
+std::size_t bucket(std::uint64_t value) {
+  if (value < 4) {
+    return value;
+  }
+  const int exponent = 63 - __builtin_clzll(value);
+  const std::size_t index =
+      4 * (exponent - 1) + ((value >> (exponent - 2)) & 3);
+  return std::min(index, Profiler::Histogram::kBuckets - 1);
+}
+
+// Largest value that falls into bucket index
+std::uint64_t upperBound(std::size_t index) {
+  if (index < 4) {
+    return index;
+  }
+  const int exponent = index / 4 + 1;
+  const std::uint64_t lower = (4 + index % 4) << (exponent - 2);
+  return lower + (std::uint64_t(1) << (exponent - 2)) - 1;
+}
+
+// Format value of metric into buffer, durations with a unit that keeps
+// three significant digits
+void formatValue(Profiler::Metric metric, std::uint64_t value, char* buffer,
+                 std::size_t size) {
+  if (*Profiler::Unit(metric) == '\0') {
+    std::snprintf(buffer, size, "%llu", (unsigned long long)value);
+  } else if (value < 1000) {
+    std::snprintf(buffer, size, "%lluns", (unsigned long long)value);
+  } else if (value < 1000000) {
+    std::snprintf(buffer, size, "%.1fus", value / 1e3);
+  } else if (value < 1000000000) {
+    std::snprintf(buffer, size, "%.1fms", value / 1e6);
+  } else {
+    std::snprintf(buffer, size, "%.2fs", value / 1e9);
+  }
+}
+
+#if MONITOR_PROFILING
+std::atomic<std::uint64_t> allocations{0};
+
+// Return the read and write system calls of this process so far
+std::uint64_t syscalls() {
+  static ProcFile file;
+  static std::string content;
+  if (!file.Read("/proc/self/io", content)) {
+    return 0;
+  }
+  std::uint64_t total = 0;
+  for (const char* key : {"syscr: ", "syscw: "}) {
+    const auto position = content.find(key);
+    if (position != std::string::npos) {
+      total += std::strtoull(content.c_str() + position + 7, nullptr, 10);
+    }
+  }
+  return total;
+}
+#endif
+}  // namespace
+
+#if MONITOR_PROFILING
+// Count every allocation of the program
+void* operator new(std::size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void* memory = std::malloc(size ? size : 1)) {
+    return memory;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept { std::free(memory); }
+
+void operator delete(void* memory, std::size_t) noexcept {
+  std::free(memory);
+}
+#endif
+
+void Profiler::Histogram::Record(std::uint64_t value) {
+  buckets_[bucket(value)].fetch_add(1, std::memory_order_relaxed);
+  count_.fetch_add(1, std::memory_order_relaxed);
+  std::uint64_t max = max_.load(std::memory_order_relaxed);
+  while (value > max &&
+         !max_.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+  }
+}
+
+void Profiler::Histogram::Reset() {
+  for (auto& bucket : buckets_) {
+    bucket.store(0, std::memory_order_relaxed);
+  }
+  count_.store(0, std::memory_order_relaxed);
+  max_.store(0, std::memory_order_relaxed);
+}
+
+std::uint64_t Profiler::Histogram::Count() const {
+  return count_.load(std::memory_order_relaxed);
+}
+
+std::uint64_t Profiler::Histogram::Percentile(double share) const {
+  const std::uint64_t count = Count();
+  if (count == 0) {
+    return 0;
+  }
+  const std::uint64_t rank = std::max<std::uint64_t>(1, share * count + 0.5);
+  std::uint64_t seen = 0;
+  for (std::size_t index = 0; index < kBuckets; ++index) {
+    seen += buckets_[index].load(std::memory_order_relaxed);
+    if (seen >= rank) {
+      // The exact maximum is a tighter bound for the highest bucket
+      return std::min(upperBound(index), Max());
+    }
+  }
+  return Max();
+}
+
+std::uint64_t Profiler::Histogram::Max() const {
+  return max_.load(std::memory_order_relaxed);
+}
+
+const char* Profiler::Name(Metric metric) {
+  return descriptions[static_cast<int>(metric)].name;
+}
+
+const char* Profiler::Unit(Metric metric) {
+  return descriptions[static_cast<int>(metric)].unit;
+}
+
+Profiler::Histogram& Profiler::Get(Metric metric) {
+  return histograms[static_cast<int>(metric)];
+}
+
+void Profiler::EndTick() {
+#if MONITOR_PROFILING
+  static std::uint64_t lastAllocations = 0;
+  static std::uint64_t lastSyscalls = 0;
+  const std::uint64_t currentAllocations =
+      allocations.load(std::memory_order_relaxed);
+  // Reading /proc/self/io shows the calls before that read
+  const std::uint64_t currentSyscalls = syscalls();
+  if (lastSyscalls != 0) {
+    Get(Metric::kAllocations).Record(currentAllocations - lastAllocations);
+    Get(Metric::kSyscalls).Record(currentSyscalls - lastSyscalls - 1);
+  }
+  lastAllocations = currentAllocations;
+  lastSyscalls = currentSyscalls;
+#endif
+}
+
+std::size_t Profiler::FormatRow(int row, char* buffer, std::size_t size) {
+  if (row == 0) {
+    return std::snprintf(buffer, size, "%-12s %9s %9s %9s %9s", "metric",
+                         "count", "p50", "p99", "max");
+  }
+  const auto metric = static_cast<Metric>(row - 1);
+  const Histogram& histogram = Get(metric);
+  char p50[16];
+  char p99[16];
+  char max[16];
+  formatValue(metric, histogram.Percentile(0.5), p50, sizeof(p50));
+  formatValue(metric, histogram.Percentile(0.99), p99, sizeof(p99));
+  formatValue(metric, histogram.Max(), max, sizeof(max));
+  return std::snprintf(buffer, size, "%-12s %9llu %9s %9s %9s", Name(metric),
+                       (unsigned long long)histogram.Count(), p50, p99, max);
+}
+
+std::string Profiler::Report() {
+  std::string report;
+  char row[kRowSize];
+  for (int i = 0; i < kRows; ++i) {
+    const std::size_t length = FormatRow(i, row, sizeof(row));
+    report.append(row, std::min(length, sizeof(row) - 1));
+    report.push_back('\n');
+  }
+  return report;
+}
@@ -0,0 +1,310 @@
+#include "recording.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+using Recording::FileHeader;
+using Recording::ProcessRecord;
+using Recording::SlotHeader;
+
+constexpr std::uint64_t kAlignment{64};
+
+std::uint64_t align(std::uint64_t size) {
+  return (size + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+// Return the header a recording with this layout starts with
+FileHeader layout(std::uint32_t slots, std::uint32_t cores,
+                  std::uint32_t processes) {
+  FileHeader header{};
+  std::memcpy(header.magic, Recording::kMagic, sizeof(header.magic));
+  header.version = Recording::kVersion;
+  header.slotSize = align(sizeof(SlotHeader) + cores * sizeof(float) +
+                          processes * sizeof(ProcessRecord));
+  header.slots = slots;
+  header.cores = cores;
+  header.processes = processes;
+  header.dataOffset = align(sizeof(FileHeader));
+  return header;
+}
+
+std::uint64_t fileSize(const FileHeader& header) {
+  return header.dataOffset + std::uint64_t(header.slots) * header.slotSize;
+}
+
+// Return whether header describes a recording that fits into size bytes
+bool valid(const FileHeader& header, std::uint64_t size) {
+  return std::memcmp(header.magic, Recording::kMagic, sizeof(header.magic)) ==
+             0 &&
+         header.version == Recording::kVersion && header.slots > 0 &&
+         header.dataOffset >= sizeof(FileHeader) &&
+         header.slotSize >= sizeof(SlotHeader) +
+                                header.cores * sizeof(float) +
+                                header.processes * sizeof(ProcessRecord) &&
+         fileSize(header) == size;
+}
+
+template <typename TBase>
+TBase* slotAt(TBase* base, std::uint32_t slot) {
+  const auto& header = *reinterpret_cast<const FileHeader*>(base);
+  return base + header.dataOffset + std::uint64_t(slot) * header.slotSize;
+}
+
+template <std::size_t N>
+void copyString(char (&target)[N], const std::string& source) {
+  const std::size_t length = std::min(source.size(), N - 1);
+  std::memcpy(target, source.data(), length);
+  std::memset(target + length, 0, N - length);
+}
+
+std::string systemError(const std::string& path) {
+  return path + ": " + std::strerror(errno);
+}
+}  // namespace
+
+Recording::Writer::~Writer() {
+  if (base_ != nullptr) {
+    munmap(base_, size_);
+  }
+}
+
+bool Recording::Writer::Open(const std::string& path, std::uint32_t slots,
+                             std::uint32_t cores, std::uint32_t processes,
+                             std::string& error) {
+  int fd = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    error = systemError(path);
+    return false;
+  }
+
+  const FileHeader wanted = layout(slots, cores, processes);
+  const std::uint64_t size = fileSize(wanted);
+  struct stat status {};
+  FileHeader existing{};
+  const bool reuse =
+      fstat(fd, &status) == 0 && std::uint64_t(status.st_size) == size &&
+      pread(fd, &existing, sizeof(existing), 0) == sizeof(existing) &&
+      valid(existing, size) && existing.slotSize == wanted.slotSize &&
+      existing.cores == cores && existing.processes == processes;
+  if (!reuse) {
+    // Allocate every block up front, a full disk would otherwise show up as
+    // SIGBUS on a store into the mapping.
+    int result = ftruncate(fd, 0);
+    if (result == 0) {
+      result = posix_fallocate(fd, 0, size);
+      errno = result;
+    }
+    if (result != 0) {
+      error = systemError(path);
+      close(fd);
+      return false;
+    }
+  }
+
+  void* mapping =
+      mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    error = systemError(path);
+    return false;
+  }
+  if (base_ != nullptr) {
+    munmap(base_, size_);
+  }
+  base_ = static_cast<char*>(mapping);
+  size_ = size;
+
+  next_ = 0;
+  if (reuse) {
+    // Continue after the newest record, complete or not
+    for (std::uint32_t slot = 0; slot < slots; ++slot) {
+      const std::uint64_t sequence =
+          reinterpret_cast<SlotHeader*>(slotAt(base_, slot))
+              ->sequence.load(std::memory_order_relaxed);
+      if (sequence > 0) {
+        next_ = std::max(next_, (sequence - 1) / 2 + 1);
+      }
+    }
+  } else {
+    // The magic goes in last, an interrupted initialisation is redone on the
+    // next start.
+    FileHeader header = wanted;
+    std::memset(header.magic, 0, sizeof(header.magic));
+    std::memcpy(base_, &header, sizeof(header));
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(base_, wanted.magic, sizeof(wanted.magic));
+  }
+  return true;
+}
+
+void Recording::Writer::Append(const Sample& sample) {
+  if (base_ == nullptr) {
+    return;
+  }
+  const auto& header = *reinterpret_cast<const FileHeader*>(base_);
+  char* slot = slotAt(base_, next_ % header.slots);
+  auto& record = *reinterpret_cast<SlotHeader*>(slot);
+
+  // Seqlock: readers that see an odd number or a change skip the slot.
+  record.sequence.store(2 * next_ + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  record.tick = sample.tick;
+  record.timestamp = sample.timestamp;
+  record.cpu = sample.cpu;
+  record.steal = sample.steal;
+  record.memory = sample.memory;
+  record.coreCount = std::min<std::size_t>(sample.cores.size(), header.cores);
+  record.processCount =
+      std::min<std::size_t>(sample.processes.size(), header.processes);
+  record.totalProcesses = sample.totalProcesses;
+  record.runningProcesses = sample.runningProcesses;
+  record.uptime = sample.uptime;
+  record.contextSwitches = sample.contextSwitches;
+  record.interrupts = sample.interrupts;
+
+  auto* cores = reinterpret_cast<float*>(slot + sizeof(SlotHeader));
+  std::copy_n(sample.cores.begin(), record.coreCount, cores);
+  auto* processes =
+      reinterpret_cast<ProcessRecord*>(cores + header.cores);
+  for (std::uint32_t i = 0; i < record.processCount; ++i) {
+    const Process& process = sample.processes[i];
+    ProcessRecord& target = processes[i];
+    target.pid = process.Pid();
+    target.cpu = process.CpuUtilization();
+    target.ramMb = process.RamMb();
+    target.uptime = process.UpTime();
+    target.readRate = process.ReadRate();
+    target.writeRate = process.WriteRate();
+    copyString(target.user, process.User());
+    const std::string& command = process.Command();
+    target.commandLength =
+        std::min<std::size_t>(command.size(), sizeof(target.command));
+    std::memcpy(target.command, command.data(), target.commandLength);
+    std::memset(target.command + target.commandLength, 0,
+                sizeof(target.command) - target.commandLength);
+  }
+
+  record.sequence.store(2 * next_ + 2, std::memory_order_release);
+  ++next_;
+}
+
+Recording::Reader::~Reader() {
+  if (base_ != nullptr) {
+    munmap(const_cast<char*>(base_), size_);
+  }
+}
+
+bool Recording::Reader::Open(const std::string& path, std::string& error) {
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    error = systemError(path);
+    return false;
+  }
+  struct stat status {};
+  if (fstat(fd, &status) != 0) {
+    error = systemError(path);
+    close(fd);
+    return false;
+  }
+  FileHeader header{};
+  if (pread(fd, &header, sizeof(header), 0) != sizeof(header) ||
+      !valid(header, status.st_size)) {
+    error = path + ": not a recording";
+    close(fd);
+    return false;
+  }
+
+  void* mapping = mmap(nullptr, status.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    error = systemError(path);
+    return false;
+  }
+  if (base_ != nullptr) {
+    munmap(const_cast<char*>(base_), size_);
+  }
+  base_ = static_cast<const char*>(mapping);
+  size_ = status.st_size;
+  return true;
+}
+
+std::uint32_t Recording::Reader::Slots() const {
+  return base_ ? reinterpret_cast<const FileHeader*>(base_)->slots : 0;
+}
+
+std::uint64_t Recording::Reader::Records() const {
+  std::uint64_t records = 0;
+  for (std::uint32_t slot = 0; slot < Slots(); ++slot) {
+    const std::uint64_t sequence =
+        reinterpret_cast<const SlotHeader*>(slotAt(base_, slot))
+            ->sequence.load(std::memory_order_acquire);
+    if (sequence > 0 && sequence % 2 == 0) {
+      records = std::max(records, sequence / 2);
+    }
+  }
+  return records;
+}
+
+bool Recording::Reader::Timestamp(std::uint64_t record,
+                                  std::int64_t& timestamp) const {
+  const auto& slot = *reinterpret_cast<const SlotHeader*>(
+      slotAt(base_, record % Slots()));
+  const std::uint64_t sequence = 2 * record + 2;
+  if (slot.sequence.load(std::memory_order_acquire) != sequence) {
+    return false;
+  }
+  timestamp = slot.timestamp;
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return slot.sequence.load(std::memory_order_relaxed) == sequence;
+}
+
+bool Recording::Reader::Read(std::uint64_t record, Sample& sample) const {
+  const auto& header = *reinterpret_cast<const FileHeader*>(base_);
+  const char* data = slotAt(base_, record % header.slots);
+  const auto& slot = *reinterpret_cast<const SlotHeader*>(data);
+  const std::uint64_t sequence = 2 * record + 2;
+  if (slot.sequence.load(std::memory_order_acquire) != sequence) {
+    return false;
+  }
+
+  sample.tick = slot.tick;
+  sample.timestamp = slot.timestamp;
+  sample.cpu = slot.cpu;
+  sample.steal = slot.steal;
+  sample.memory = slot.memory;
+  sample.uptime = slot.uptime;
+  sample.totalProcesses = slot.totalProcesses;
+  sample.runningProcesses = slot.runningProcesses;
+  sample.contextSwitches = slot.contextSwitches;
+  sample.interrupts = slot.interrupts;
+
+  const auto* cores = reinterpret_cast<const float*>(data + sizeof(SlotHeader));
+  sample.cores.assign(cores, cores + std::min(slot.coreCount, header.cores));
+  const auto* processes =
+      reinterpret_cast<const ProcessRecord*>(cores + header.cores);
+  const std::uint32_t count = std::min(slot.processCount, header.processes);
+  sample.processes.clear();
+  for (std::uint32_t i = 0; i < count; ++i) {
+    const ProcessRecord& process = processes[i];
+    sample.processes.emplace_back(
+        process.pid,
+        std::string(process.user, strnlen(process.user, sizeof(process.user))),
+        std::string(process.command,
+                    std::min<std::size_t>(process.commandLength,
+                                          sizeof(process.command))),
+        process.cpu, process.ramMb, process.uptime, process.readRate,
+        process.writeRate);
+  }
+
+  // Valid only if the writer did not start on the slot meanwhile
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return slot.sequence.load(std::memory_order_relaxed) == sequence;
+}
@@ -0,0 +1,132 @@
+#include "replay_system.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+
+using std::string;
+using std::vector;
+
+// Nothing is read from /proc, a single worker avoids idle threads
+ReplaySystem::ReplaySystem() : System(1) {}
+
+bool ReplaySystem::Open(const string& path, string& error) {
+  if (!reader_.Open(path, error)) {
+    return false;
+  }
+  const std::uint64_t records = reader_.Records();
+  if (records == 0) {
+    error = path + ": no complete records";
+    return false;
+  }
+  path_ = path;
+  operatingSystem_ = "replay of " + path;
+  last_ = records - 1;
+  first_ = records > reader_.Slots() ? records - reader_.Slots() : 0;
+  // The oldest slot may be torn or already overwritten by a live monitor
+  while (!reader_.Timestamp(first_, begin_)) {
+    if (first_ == last_) {
+      error = path + ": no readable records";
+      return false;
+    }
+    ++first_;
+  }
+  if (!reader_.Timestamp(last_, end_)) {
+    end_ = begin_;
+  }
+
+  timeIndex_.clear();
+  std::int64_t timestamp;
+  for (std::uint64_t record = first_; record <= last_;
+       record += kIndexStride) {
+    if (reader_.Timestamp(record, timestamp)) {
+      timeIndex_.emplace_back(timestamp, record);
+    }
+  }
+
+  loaded_ = false;
+  lastTick_ = std::chrono::steady_clock::now();
+  SeekTo(begin_);
+  if (!loaded_) {
+    error = path + ": no readable records";
+    return false;
+  }
+  return true;
+}
+
+// Advance the playback clock by the time since the last refresh
+void ReplaySystem::Refresh() {
+  const auto now = std::chrono::steady_clock::now();
+  if (!paused_) {
+    clock_ += std::chrono::duration<double, std::milli>(now - lastTick_)
+                  .count() *
+              speed_;
+  }
+  lastTick_ = now;
+  SeekTo(clock_);
+}
+
+const ProcessTable& ReplaySystem::Processes() { return Table(); }
+
+float ReplaySystem::MemoryUtilization() { return sample_.memory; }
+
+long ReplaySystem::UpTime() { return sample_.uptime; }
+
+const string& ReplaySystem::Kernel() { return kernel_; }
+
+const string& ReplaySystem::OperatingSystem() { return operatingSystem_; }
+
+void ReplaySystem::TogglePause() { paused_ = !paused_; }
+
+bool ReplaySystem::Paused() const { return paused_; }
+
+void ReplaySystem::SetSpeed(double speed) {
+  speed_ = std::clamp(speed, 1.0, 100.0);
+}
+
+double ReplaySystem::Speed() const { return speed_; }
+
+void ReplaySystem::Seek(std::chrono::milliseconds delta) {
+  SeekTo(clock_ + delta.count());
+}
+
+// Binary search the sparse index, then step through at most kIndexStride
+// records
+void ReplaySystem::SeekTo(std::int64_t timestamp) {
+  clock_ = std::clamp(timestamp, begin_, end_);
+  auto next = std::upper_bound(
+      timeIndex_.begin(), timeIndex_.end(),
+      std::make_pair(clock_, std::numeric_limits<std::uint64_t>::max()));
+  std::uint64_t record =
+      next == timeIndex_.begin() ? first_ : std::prev(next)->second;
+  const std::uint64_t end = next == timeIndex_.end() ? last_ : next->second;
+  std::int64_t recorded;
+  for (std::uint64_t candidate = record + 1; candidate <= end; ++candidate) {
+    if (!reader_.Timestamp(candidate, recorded)) {
+      continue;
+    }
+    if (recorded > clock_) {
+      break;
+    }
+    record = candidate;
+  }
+  Show(record);
+}
+
+std::int64_t ReplaySystem::Begin() const { return begin_; }
+
+std::int64_t ReplaySystem::End() const { return end_; }
+
+std::int64_t ReplaySystem::Timestamp() const { return sample_.timestamp; }
+
+void ReplaySystem::Show(std::uint64_t record) {
+  if (loaded_ && record == position_) {
+    return;
+  }
+  if (reader_.Read(record, sample_)) {
+    Load(sample_);
+    position_ = record;
+    loaded_ = true;
+  }
+}
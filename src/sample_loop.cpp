@@ -0,0 +1,72 @@
+#include "sample_loop.h"
+
+#include <signal.h>
+
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+#include "options.h"
+#include "profiler.h"
+
+namespace {
+volatile sig_atomic_t stopRequested = 0;
+
+void requestStop(int) { stopRequested = 1; }
+}  // namespace
+
+void SampleLoop::CatchStopSignals() {
+  struct sigaction action {};
+  action.sa_handler = requestStop;
+  sigaction(SIGINT, &action, nullptr);
+  sigaction(SIGTERM, &action, nullptr);
+}
+
+bool SampleLoop::StopRequested() { return stopRequested != 0; }
+
+void SampleLoop::Run(System& system, const Options& options, long iterations,
+                     Recording::Writer* recorder, const Consumer& consume) {
+  CatchStopSignals();
+  // Writing to a closed pipe or socket fails with EPIPE instead
+  signal(SIGPIPE, SIG_IGN);
+
+  // The first refresh only provides the baseline for interval CPU values.
+  system.Collect();
+
+  Sample sample;
+  long late = 0;
+  auto next = std::chrono::steady_clock::now();
+  for (long tick = 0;
+       !stopRequested && (iterations == 0 || tick < iterations); ++tick) {
+    next += options.interval;
+    std::this_thread::sleep_until(next);
+    if (stopRequested) {
+      break;
+    }
+
+    {
+      PROFILE_SCOPE(kTick);
+      system.Collect();
+      system.Capture(sample, options.top);
+    }
+    Profiler::EndTick();
+    sample.tick = tick;
+    if (recorder != nullptr) {
+      recorder->Append(sample);
+    }
+    if (!consume(sample)) {
+      break;
+    }
+
+    // Falling behind skips the missed ticks instead of sampling in a burst.
+    const auto now = std::chrono::steady_clock::now();
+    if (now > next + options.interval) {
+      ++late;
+      next = now;
+    }
+  }
+
+  if (late > 0) {
+    std::fprintf(stderr, "%ld ticks took longer than the interval\n", late);
+  }
+}
@@ -0,0 +1,133 @@
+#include "sample_scheduler.h"
+
+#include <algorithm>
+
+void SampleScheduler::Configure(bool tiered, const Budget& budget) {
+  tiered_ = tiered;
+  budget_ = budget;
+}
+
+bool SampleScheduler::Tiered() const { return tiered_; }
+
+const std::vector<std::uint32_t>& SampleScheduler::Plan(
+    const std::vector<int>& pids) {
+  ++tick_;
+  // Both are ordered by pid, one merge carries the schedule over
+  next_.resize(pids.size());
+  std::size_t previous = 0;
+  for (std::size_t i = 0; i < pids.size(); ++i) {
+    while (previous < entries_.size() && entries_[previous].pid < pids[i]) {
+      ++previous;
+    }
+    Entry& entry = next_[i];
+    if (previous < entries_.size() && entries_[previous].pid == pids[i]) {
+      entry = entries_[previous];
+    } else {
+      entry = Entry{};
+      entry.pid = pids[i];
+      entry.due = tick_;
+    }
+    if (wake_ || !tiered_) {
+      entry.due = std::min(entry.due, tick_);
+    }
+  }
+  entries_.swap(next_);
+  wake_ = false;
+
+  auto cost = [](const Entry& entry) {
+    return entry.read ? kReadSyscalls : kFirstReadSyscalls;
+  };
+  planned_.clear();
+  std::size_t syscalls = 0;
+  for (std::size_t i = 0; i < entries_.size(); ++i) {
+    if (entries_[i].due <= tick_) {
+      planned_.emplace_back(static_cast<std::uint32_t>(i));
+      syscalls += cost(entries_[i]);
+    }
+  }
+  // No estimate before the first tick was timed
+  const std::size_t reads =
+      budget_.time.count() == 0 || readCost_ <= 0
+          ? planned_.size()
+          : static_cast<std::size_t>(
+                std::chrono::nanoseconds(budget_.time).count() / readCost_);
+  if ((budget_.syscalls == 0 || syscalls <= budget_.syscalls) &&
+      planned_.size() <= reads) {
+    complete_ = planned_.size() == entries_.size();
+    return planned_;
+  }
+
+  // Busy, then new, then idle, each one kMaxInterval ticks behind the
+  // other, so an idle process skipped long enough overtakes a busy one. At
+  // least one read per tick, however small the budget.
+  auto priority = [this](std::uint32_t i) {
+    const Entry& entry = entries_[i];
+    const std::uint64_t rank = !entry.read ? 1 : entry.active ? 0 : 2;
+    return entry.due + rank * kMaxInterval;
+  };
+  std::sort(planned_.begin(), planned_.end(),
+            [&](std::uint32_t a, std::uint32_t b) {
+              const std::uint64_t priorityA = priority(a);
+              const std::uint64_t priorityB = priority(b);
+              return priorityA != priorityB ? priorityA < priorityB : a < b;
+            });
+  std::size_t taken = 0;
+  syscalls = 0;
+  for (; taken < planned_.size(); ++taken) {
+    const std::size_t next = syscalls + cost(entries_[planned_[taken]]);
+    if (taken > 0 && ((budget_.syscalls != 0 && next > budget_.syscalls) ||
+                      taken >= reads)) {
+      break;
+    }
+    syscalls = next;
+  }
+  planned_.resize(taken);
+  std::sort(planned_.begin(), planned_.end());
+  complete_ = false;
+  return planned_;
+}
+
+// An idle process backs off, one that ran or is new starts over at one tick.
+// The wait is spread over the upper half of the interval by pid, or the
+// processes found idle together would all come due on the same tick.
+double SampleScheduler::Sampled(std::size_t i, unsigned long long starttime,
+                                unsigned long activeJiffies,
+                                std::chrono::steady_clock::time_point now) {
+  Entry& entry = entries_[i];
+  const bool same = entry.read && entry.starttime == starttime;
+  const double elapsed =
+      same ? std::chrono::duration<double>(now - entry.lastRead).count() : 0;
+  entry.active = !same || activeJiffies != entry.activeJiffies;
+  entry.interval = entry.active || !tiered_
+                       ? 1
+                       : std::min(entry.interval * 2, kMaxInterval);
+  entry.due = tick_ + entry.interval -
+              static_cast<std::uint32_t>(entry.pid) % (entry.interval / 2 + 1);
+  entry.read = true;
+  entry.starttime = starttime;
+  entry.activeJiffies = activeJiffies;
+  entry.lastRead = now;
+  return elapsed;
+}
+
+void SampleScheduler::Spent(std::chrono::nanoseconds time) {
+  if (planned_.empty()) {
+    return;
+  }
+  const double cost = double(time.count()) / planned_.size();
+  readCost_ = readCost_ <= 0 ? cost : 0.8 * readCost_ + 0.2 * cost;
+}
+
+// The floor is the lowest unexplained CPU since the last tick that read
+// every process, it only rises again with the next such tick
+void SampleScheduler::Unexplained(float cpu) {
+  cpu = std::max(cpu, 0.0f);
+  if (complete_) {
+    noiseFloor_ = cpu;
+    return;
+  }
+  noiseFloor_ = std::min(noiseFloor_, cpu);
+  if (tiered_ && cpu > noiseFloor_ + kWakeCpu) {
+    wake_ = true;
+  }
+}
@@ -0,0 +1,160 @@
+#include "sampler.h"
+
+#include "collectors.h"
+#include "profiler.h"
+
+Sampler::Sampler(System& system, std::size_t top,
+                 std::chrono::milliseconds interval,
+                 Recording::Writer* recorder)
+    : system_(system),
+      top_(top),
+      recorder_(recorder),
+      interval_(interval),
+      sortColumn_(system.SortedBy()),
+      threadSelection_(system.SelectedThreads()),
+      showCgroups_(system.ShowingCgroups()) {
+  thread_ = std::thread(&Sampler::Loop, this);
+}
+
+Sampler::~Sampler() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  wake_.notify_one();
+  thread_.join();
+}
+
+const Sample* Sampler::Latest() {
+  if ((middle_.load(std::memory_order_acquire) & kFresh) == 0) {
+    return nullptr;
+  }
+  front_ = middle_.exchange(front_, std::memory_order_acq_rel) & ~kFresh;
+  return &buffers_[front_];
+}
+
+void Sampler::SetInterval(std::chrono::milliseconds interval) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    interval_ = interval;
+  }
+  wake_.notify_one();
+}
+
+std::chrono::milliseconds Sampler::Interval() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return interval_;
+}
+
+void Sampler::SortBy(System::SortColumn column) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    sortColumn_ = column;
+    resort_ = true;
+  }
+  wake_.notify_one();
+}
+
+System::SortColumn Sampler::SortedBy() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return sortColumn_;
+}
+
+void Sampler::SelectThreads(const System::ThreadSelection& selection) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    threadSelection_ = selection;
+    reselect_ = true;
+  }
+  wake_.notify_one();
+}
+
+System::ThreadSelection Sampler::SelectedThreads() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return threadSelection_;
+}
+
+void Sampler::ShowCgroups(bool show) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    showCgroups_ = show;
+    reselect_ = true;
+  }
+  wake_.notify_one();
+}
+
+bool Sampler::ShowingCgroups() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return showCgroups_;
+}
+
+void Sampler::Loop() {
+  std::uint64_t tick = 0;
+  // Start of the current tick. Advances by the interval, so the sampling
+  // time does not add up.
+  auto scheduled = std::chrono::steady_clock::now();
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (!stop_) {
+    // A new sort order only reorders the table of the current tick, a new
+    // thread selection or view only reads the threads or cgroups
+    const bool reselect = reselect_;
+    const bool resort = resort_ || reselect;
+    resort_ = false;
+    reselect_ = false;
+    const System::SortColumn column = sortColumn_;
+    system_.SelectThreads(threadSelection_);
+    system_.ShowCgroups(showCgroups_);
+    // The cgroup counters replace the per process reads, unless every
+    // sample goes to the recorder
+    const bool cgroupsOnly = showCgroups_ && recorder_ == nullptr;
+    lock.unlock();
+
+    system_.SortBy(column);
+    Sample& sample = buffers_[back_];
+    if (resort) {
+      if (reselect) {
+        system_.Collect(Collectors::Bit(Collectors::Id::kThreads) |
+                        Collectors::Bit(Collectors::Id::kCgroups));
+      }
+      system_.Capture(sample, top_);
+    } else {
+      {
+        PROFILE_SCOPE(kTick);
+        if (cgroupsOnly) {
+          system_.Collect(Collectors::kAll & ~Collectors::kPerProcess);
+        } else {
+          system_.Collect();
+        }
+        system_.Capture(sample, top_);
+        ++tick;
+      }
+      Profiler::EndTick();
+    }
+    sample.tick = tick - 1;
+    if (!resort && recorder_ != nullptr) {
+      recorder_->Append(sample);
+    }
+    Publish();
+
+    lock.lock();
+    // Waking up re-evaluates the deadline, a new interval applies at once
+    while (!stop_ && !resort_ && !reselect_ &&
+           std::chrono::steady_clock::now() < scheduled + interval_) {
+      wake_.wait_until(lock, scheduled + interval_);
+    }
+    if (!stop_ && !resort_ && !reselect_) {
+      scheduled += interval_;
+      // Falling behind skips the missed ticks instead of sampling in a burst
+      const auto now = std::chrono::steady_clock::now();
+      if (now - scheduled > interval_) {
+        scheduled = now;
+      }
+    }
+  }
+}
+
+// Hand the back buffer to the reader and take the one it left in the middle
+void Sampler::Publish() {
+  back_ = middle_.exchange(back_ | kFresh, std::memory_order_acq_rel) &
+          ~kFresh;
+}
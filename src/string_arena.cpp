@@ -0,0 +1,130 @@
+#include "string_arena.h"
+
+#include <algorithm>
+#include <functional>
+
+StringArena::StringArena() : entries_(1), slots_(16, kEmpty) {}
+
+StringArena::Id StringArena::Intern(std::string_view text) {
+  if (text.empty()) {
+    return kEmpty;
+  }
+  const std::size_t hash = std::hash<std::string_view>{}(text);
+  const std::size_t mask = slots_.size() - 1;
+  std::size_t insert = slots_.size();
+  std::size_t slot = hash & mask;
+  for (; slots_[slot] != kEmpty; slot = (slot + 1) & mask) {
+    const Id id = slots_[slot];
+    if (id == kTombstone) {
+      insert = std::min(insert, slot);
+      continue;
+    }
+    if (entries_[id].hash == hash && View(id) == text) {
+      ++entries_[id].references;
+      return id;
+    }
+  }
+  if (insert == slots_.size()) {
+    insert = slot;
+  } else {
+    --tombstones_;
+  }
+
+  Id id;
+  if (free_.empty()) {
+    id = static_cast<Id>(entries_.size());
+    entries_.emplace_back();
+  } else {
+    id = free_.back();
+    free_.pop_back();
+  }
+  entries_[id] = {static_cast<std::uint32_t>(buffer_.size()),
+                  static_cast<std::uint32_t>(text.size()), 1, hash};
+  buffer_.insert(buffer_.end(), text.begin(), text.end());
+  slots_[insert] = id;
+  ++live_;
+  // At most three quarters full, tombstones included
+  if ((live_ + tombstones_) * 4 > slots_.size() * 3) {
+    std::size_t slots = 16;
+    while (live_ * 2 > slots) {
+      slots *= 2;
+    }
+    Rehash(slots);
+  }
+  return id;
+}
+
+void StringArena::Acquire(Id id) {
+  if (id != kEmpty) {
+    ++entries_[id].references;
+  }
+}
+
+void StringArena::Release(Id id) {
+  if (id == kEmpty || --entries_[id].references > 0) {
+    return;
+  }
+  const std::size_t mask = slots_.size() - 1;
+  std::size_t slot = entries_[id].hash & mask;
+  while (slots_[slot] != id) {
+    slot = (slot + 1) & mask;
+  }
+  slots_[slot] = kTombstone;
+  ++tombstones_;
+  --live_;
+  garbage_ += entries_[id].length;
+  free_.emplace_back(id);
+  if (buffer_.size() >= kCompactSize && garbage_ * 2 > buffer_.size()) {
+    Compact();
+  }
+}
+
+std::string_view StringArena::View(Id id) const {
+  const Entry& entry = entries_[id];
+  return {buffer_.data() + entry.offset, entry.length};
+}
+
+std::size_t StringArena::Size() const { return buffer_.size(); }
+
+// Rebuild the lookup table without tombstones
+void StringArena::Rehash(std::size_t slots) {
+  slots_.assign(slots, kEmpty);
+  tombstones_ = 0;
+  const std::size_t mask = slots - 1;
+  for (Id id = 1; id < entries_.size(); ++id) {
+    if (entries_[id].references == 0) {
+      continue;
+    }
+    std::size_t slot = entries_[id].hash & mask;
+    while (slots_[slot] != kEmpty) {
+      slot = (slot + 1) & mask;
+    }
+    slots_[slot] = id;
+  }
+}
+
+// Move the live strings to the front in buffer order, which keeps every
+// string ahead of where it was, so they can be moved in place
+void StringArena::Compact() {
+  std::vector<Id> order;
+  order.reserve(live_);
+  for (Id id = 1; id < entries_.size(); ++id) {
+    if (entries_[id].references > 0) {
+      order.emplace_back(id);
+    }
+  }
+  std::sort(order.begin(), order.end(), [this](Id a, Id b) {
+    return entries_[a].offset < entries_[b].offset;
+  });
+  std::uint32_t offset = 0;
+  for (const Id id : order) {
+    Entry& entry = entries_[id];
+    std::copy(buffer_.begin() + entry.offset,
+              buffer_.begin() + entry.offset + entry.length,
+              buffer_.begin() + offset);
+    entry.offset = offset;
+    offset += entry.length;
+  }
+  buffer_.resize(offset);
+  garbage_ = 0;
+}
@@ -1,44 +1,681 @@
 #include "system.h"
-#include "linux_parser.h"
 
 #include <unistd.h>
 
+#include <algorithm>
+#include <chrono>
 #include <cstddef>
+#include <functional>
+#include <numeric>
 #include <set>
 #include <string>
 #include <vector>
 
+#include "linux_parser.h"
+#include "profiler.h"
+#include "sample.h"
 
 using namespace std;
 
+#if MONITOR_COLLECT_PROCESSES || MONITOR_COLLECT_CGROUPS
+System::System(std::size_t threads) : pool_(threads) {
+  Enable(Collectors::kBuilt);
+}
+#else
+// Nothing is read in parallel, no workers are started
+System::System(std::size_t) { Enable(Collectors::kBuilt); }
+#endif
+
+// Build the plan Collect() and Capture() walk. The steps of collectors that
+// were not built do not exist, nor do their tables.
+void System::Enable(Collectors::Set set) {
+  using Collectors::Id;
+  enabled_ = Collectors::WithDependencies(set) & Collectors::kBuilt;
+  steps_.clear();
+  captureSteps_.clear();
+  auto on = [this](Id id) {
+    return (enabled_ & Collectors::Bit(id)) != 0;
+  };
+#if MONITOR_COLLECT_CPU
+  if (on(Id::kCpu)) {
+    steps_.push_back({Id::kCpu, &System::Refresh});
+    captureSteps_.emplace_back(&System::CaptureCpu);
+  }
+#endif
+#if MONITOR_COLLECT_MEMORY
+  if (on(Id::kMemory)) {
+    captureSteps_.emplace_back(&System::CaptureMemory);
+  }
+#endif
+#if MONITOR_COLLECT_DEVICES
+  if (on(Id::kDevices)) {
+    steps_.push_back({Id::kDevices, &System::RefreshDevices});
+    captureSteps_.emplace_back(&System::CaptureDevices);
+  }
+#endif
+#if MONITOR_COLLECT_PROCESSES
+  if (on(Id::kProcesses)) {
+    steps_.push_back({Id::kProcesses, &System::RefreshProcesses});
+    captureSteps_.emplace_back(&System::CaptureProcesses);
+  }
+#endif
+#if MONITOR_COLLECT_IO
+  if (on(Id::kIo)) {
+    steps_.push_back({Id::kIo, &System::RefreshIo});
+  }
+#endif
+#if MONITOR_COLLECT_THREADS
+  if (on(Id::kThreads)) {
+    steps_.push_back({Id::kThreads, &System::RefreshThreads});
+    captureSteps_.emplace_back(&System::CaptureThreads);
+  }
+#endif
+#if MONITOR_COLLECT_CGROUPS
+  if (on(Id::kCgroups)) {
+    steps_.push_back({Id::kCgroups, &System::RefreshCgroups});
+    captureSteps_.emplace_back(&System::CaptureCgroups);
+  }
+#endif
+}
+
+Collectors::Set System::Enabled() const { return enabled_; }
+
+void System::Collect() {
+  processesRead_ = false;
+  for (const Step& step : steps_) {
+    (this->*step.refresh)();
+  }
+}
+
+void System::Collect(Collectors::Set set) {
+  processesRead_ = false;
+  for (const Step& step : steps_) {
+    if (set & Collectors::Bit(step.collector)) {
+      (this->*step.refresh)();
+    }
+  }
+}
+
+// Take the /proc/stat snapshot all CPU and process counters come from
+void System::Refresh() {
+  if (LinuxParser::ReadStat(stat_)) {
+    cpu_.Update(stat_.cpus);
+  }
+}
+
+void System::RefreshDevices() {
+#if MONITOR_COLLECT_DEVICES
+  devices_.Refresh();
+#endif
+}
+
+// Return the /proc/stat values of the last Refresh()
+const LinuxParser::StatSnapshot& System::Stat() const { return stat_; }
+
 // Return the system's CPU
 Processor& System::Cpu() { return cpu_; }
 
 // Return a container composed of the system's processes
-vector<Process>& System::Processes() {
-  vector<int> pids = LinuxParser::Pids();
-  processes_.clear();
-  for (auto& pid : pids) {
-    processes_.emplace_back(pid);
+// The table is rebuilt by merging the scan into it: new processes are added,
+// the ones that exited are dropped. Only the pids the scheduler picks are
+// read at all, and of those only the ones missing from the metadata cache
+// read more than their stat file.
+const ProcessTable& System::Processes() {
+#if MONITOR_COLLECT_PROCESSES
+  {
+    PROFILE_SCOPE(kPids);
+    scanner_.Scan(LinuxParser::ProcDirectory());
+  }
+  const vector<int>& pids = scanner_.Pids();
+  // System wide values are read once per refresh, not once per process.
+  const long uptime = LinuxParser::UpTime();
+  LinuxParser::RefreshUsers();
+
+  metadata_.Track(pids);
+
+  // Reading /proc is spread across the pool, the table is updated serially.
+  // The stat file tells whether the pid is still the cached process.
+  const vector<std::uint32_t>& planned = scheduler_.Plan(pids);
+  snapshots_.resize(planned.size());
+  valid_.assign(planned.size(), false);
+  described_.assign(planned.size(), false);
+  const auto start = std::chrono::steady_clock::now();
+  {
+    // The whole phase, a timer per pid would contend across the workers
+    PROFILE_SCOPE(kParse);
+    pool_.ParallelFor(planned.size(), [&](size_t k, size_t) {
+      const size_t i = planned[k];
+      LinuxParser::ProcessSnapshot& snapshot = snapshots_[k];
+      valid_[k] = LinuxParser::ReadProcess(pids[i], snapshot, false);
+      if (valid_[k] && !metadata_.Current(i, snapshot.stat.starttime)) {
+        LinuxParser::ReadMetadata(pids[i], snapshot);
+        described_[k] = true;
+      }
+    });
+  }
+  const auto now = std::chrono::steady_clock::now();
+  scheduler_.Spent(now - start);
+  if (Profiler::Enabled()) {
+    Profiler::Get(Profiler::Metric::kReads).Record(planned.size());
+  }
+
+  // Both the table and the scan are ordered by pid. A row whose pid is not
+  // scanned any more exited, one that could not be read exited just now.
+  table_.Begin();
+  size_t row = 0;
+  size_t k = 0;
+  for (size_t i = 0; i < pids.size(); ++i) {
+    const int pid = pids[i];
+    while (row < table_.Size() && table_.Pids()[row] < pid) {
+      table_.Drop(row++);
+    }
+    const bool present = row < table_.Size() && table_.Pids()[row] == pid;
+    if (k == planned.size() || planned[k] != i) {
+      if (present) {
+        table_.Keep(row++, uptime);
+      }
+      continue;
+    }
+    const size_t slot = k++;
+    if (!valid_[slot]) {
+      if (present) {
+        table_.Drop(row++);
+      }
+      continue;
+    }
+    const LinuxParser::ProcessSnapshot& snapshot = snapshots_[slot];
+    if (described_[slot]) {
+      metadata_.Store(i, snapshot, LinuxParser::UserByUid(snapshot.uid));
+    }
+    const double elapsed = scheduler_.Sampled(
+        i, snapshot.stat.starttime, snapshot.stat.utime + snapshot.stat.stime,
+        now);
+    if (present && table_.SameProcess(row, snapshot)) {
+      table_.Update(row++, snapshot, uptime, elapsed);
+      continue;
+    }
+    if (present) {
+      // The pid was reused, start over instead of inheriting the old samples.
+      table_.Drop(row++);
+    }
+    table_.Add(snapshot, metadata_.CommandId(i), metadata_.UserId(i), uptime);
+  }
+  while (row < table_.Size()) {
+    table_.Drop(row++);
+  }
+  table_.Commit();
+  processesRead_ = true;
+
+  // Busy CPUs of the interval the table does not account for, the steal
+  // time belongs to other guests
+  const float busy = (cpu_.Utilization() - cpu_.Steal()) *
+                     cpu_.CoreUtilization().size();
+  const vector<float>& cpu = table_.Cpu();
+  const float explained = std::accumulate(cpu.begin(), cpu.end(), 0.0f);
+  scheduler_.Unexplained(busy - explained);
+#endif
+  return table_;
+}
+
+void System::RefreshProcesses() { Processes(); }
+
+// Read the io file of the busiest and the watched processes. There is one
+// per process and the kernel walks every thread for it, so unlike stat it
+// is not read for all of them.
+void System::RefreshIo() {
+#if MONITOR_COLLECT_IO
+  const auto now = std::chrono::steady_clock::now();
+  const vector<float>& cpu = table_.Cpu();
+  ioRows_.resize(table_.Size());
+  std::iota(ioRows_.begin(), ioRows_.end(), 0);
+  const size_t top = std::min(ioSelection_.top, ioRows_.size());
+  std::nth_element(ioRows_.begin(), ioRows_.begin() + top, ioRows_.end(),
+                   [&cpu](std::uint32_t a, std::uint32_t b) {
+                     return cpu[a] > cpu[b];
+                   });
+  ioRows_.resize(top);
+  for (const int pid : ioSelection_.watched) {
+    const size_t row = table_.Find(pid);
+    if (row < table_.Size()) {
+      ioRows_.emplace_back(row);
+    }
+  }
+  std::sort(ioRows_.begin(), ioRows_.end());
+  ioRows_.erase(std::unique(ioRows_.begin(), ioRows_.end()), ioRows_.end());
+
+  ioReads_.resize(ioRows_.size());
+  ioValid_.assign(ioRows_.size(), false);
+  const vector<int>& pids = table_.Pids();
+  {
+    PROFILE_SCOPE(kIo);
+    pool_.ParallelFor(ioRows_.size(), [&](size_t i, size_t) {
+      ioValid_[i] = LinuxParser::ReadIo(pids[ioRows_[i]], ioReads_[i]);
+    });
+  }
+  for (size_t i = 0; i < ioRows_.size(); ++i) {
+    if (ioValid_[i]) {
+      table_.SampleIo(ioRows_[i], ioReads_[i], now);
+    }
+  }
+#endif
+}
+
+#if MONITOR_COLLECT_PROCESSES
+void System::ScheduleReads(bool tiered,
+                           const SampleScheduler::Budget& budget) {
+  scheduler_.Configure(tiered, budget);
+}
+#else
+void System::ScheduleReads(bool, const SampleScheduler::Budget&) {}
+#endif
+
+// Change the column TopProcesses() and SortedProcesses() order by. Takes
+// effect on the next call, without reading /proc again.
+void System::SortBy(SortColumn column) { sortColumn_ = column; }
+
+System::SortColumn System::SortedBy() const { return sortColumn_; }
+
+// Return the n processes with the highest value in the sort column, highest
+// first. Only these n are ordered, the rest of the table is left alone.
+const vector<ProcessTable::Row>& System::TopProcesses(size_t n) {
+  PROFILE_SCOPE(kSort);
+  FillKeys();
+  n = std::min(n, keys_.size());
+  std::partial_sort(keys_.begin(), keys_.begin() + n, keys_.end(),
+                    std::greater<>());
+  top_.clear();
+  for (size_t i = 0; i < n; ++i) {
+    top_.emplace_back(table_[keys_[i].second]);
+  }
+  return top_;
+}
+
+// Return all processes ordered by the sort column, e.g. for exporting them
+vector<ProcessTable::Row> System::SortedProcesses() {
+  PROFILE_SCOPE(kSort);
+  FillKeys();
+  std::sort(keys_.begin(), keys_.end(), std::greater<>());
+  vector<ProcessTable::Row> sorted;
+  sorted.reserve(keys_.size());
+  for (const auto& key : keys_) {
+    sorted.emplace_back(table_[key.second]);
+  }
+  return sorted;
+}
+
+void System::SelectIo(const IoSelection& selection) {
+  ioSelection_ = selection;
+}
+
+const System::IoSelection& System::SelectedIo() const { return ioSelection_; }
+
+void System::SelectThreads(const ThreadSelection& selection) {
+  threadSelection_ = selection;
+}
+
+const System::ThreadSelection& System::SelectedThreads() const {
+  return threadSelection_;
+}
+
+// Only the expanded process is read per thread unless the hot view is on.
+// Nothing is read with neither.
+void System::RefreshThreads() {
+#if MONITOR_COLLECT_THREADS
+  const ThreadSelection& selection = threadSelection_;
+  threadPids_.clear();
+  const vector<int>& pids = table_.Pids();
+  const vector<float>& cpu = table_.Cpu();
+  for (size_t row = 0; row < pids.size(); ++row) {
+    if (pids[row] == selection.expanded ||
+        (selection.hot &&
+         (selection.all || cpu[row] >= selection.threshold))) {
+      threadPids_.emplace_back(pids[row]);
+    }
+  }
+  if (threadPids_.empty()) {
+    threads_.Clear();
+    return;
+  }
+  threads_.Refresh(pool_, threadPids_, LinuxParser::UpTime());
+#endif
+}
+
+void System::ShowCgroups(bool show) {
+  if (show == showCgroups_) {
+    return;
+  }
+  showCgroups_ = show;
+#if MONITOR_COLLECT_CGROUPS
+  // Start over when shown again, the pids changed in the meantime
+  cgroups_.Clear();
+  cgroupsScanned_ = false;
+#endif
+}
+
+bool System::ShowingCgroups() const { return showCgroups_; }
+
+// A pid is mapped once per (pid, starttime). With Processes() the table has
+// the starttime of every pid, a pid reused since the last refresh is read
+// again instead of keeping the cgroup of the process that had it before.
+// Without it only the pids new to the scan and the ones without a cgroup
+// are checked, a pid that stays in the scan is taken to be the same process.
+void System::RefreshCgroups() {
+#if MONITOR_COLLECT_CGROUPS
+  if (!showCgroups_) {
+    return;
+  }
+  PROFILE_SCOPE(kCgroups);
+  const vector<int>* pids = &table_.Pids();
+  cgroupMisses_.clear();
+  cgroupStarttimes_.clear();
+  if (processesRead_) {
+    const vector<unsigned long long>& starttimes = table_.Starttime();
+    cgroups_.Retain(*pids);
+    // A starttime of 0 is a process that just exited
+    for (size_t i = 0; i < pids->size(); ++i) {
+      if (starttimes[i] == 0) {
+        cgroups_.Forget((*pids)[i]);
+      } else if (!cgroups_.Known((*pids)[i], starttimes[i])) {
+        cgroupMisses_.emplace_back(i);
+        cgroupStarttimes_.emplace_back(starttimes[i]);
+      }
+    }
+    cgroupsScanned_ = false;
+  } else {
+    // The scan is compared with the previous one, unless Processes() ran in
+    // between and the cgroups followed its pids instead
+    if (!cgroupsScanned_) {
+      cgroupScanner_.Reset();
+    }
+    cgroupScanner_.Scan(LinuxParser::ProcDirectory());
+    pids = &cgroupScanner_.Pids();
+    if (cgroupsScanned_) {
+      for (int pid : cgroupScanner_.Removed()) {
+        cgroups_.Forget(pid);
+      }
+    } else {
+      cgroups_.Retain(*pids);
+    }
+    cgroupsScanned_ = true;
+    // Their starttime is read below, 0 until then
+    const vector<int>& added = cgroupScanner_.Added();
+    size_t next = 0;
+    for (size_t i = 0; i < pids->size(); ++i) {
+      const bool fresh = next < added.size() && added[next] == (*pids)[i];
+      next += fresh;
+      if (fresh || !cgroups_.Mapped((*pids)[i])) {
+        cgroupMisses_.emplace_back(i);
+        cgroupStarttimes_.emplace_back(0);
+      }
+    }
+  }
+
+  cgroupPaths_.resize(cgroupMisses_.size());
+  cgroupValid_.assign(cgroupMisses_.size(), false);
+  pool_.ParallelFor(cgroupMisses_.size(), [&](size_t k, size_t) {
+    const int pid = (*pids)[cgroupMisses_[k]];
+    if (cgroupStarttimes_[k] == 0) {
+      LinuxParser::ProcStat stat;
+      if (!LinuxParser::ParseStat(pid, stat)) {
+        return;
+      }
+      cgroupStarttimes_[k] = stat.starttime;
+      if (cgroups_.Known(pid, stat.starttime)) {
+        return;
+      }
+    }
+    cgroupValid_[k] = LinuxParser::ReadCgroup(pid, cgroupPaths_[k]);
+  });
+  for (size_t k = 0; k < cgroupMisses_.size(); ++k) {
+    const int pid = (*pids)[cgroupMisses_[k]];
+    if (cgroups_.Known(pid, cgroupStarttimes_[k])) {
+      continue;
+    }
+    if (cgroupValid_[k]) {
+      cgroups_.Map(pid, cgroupStarttimes_[k], cgroupPaths_[k]);
+    } else {
+      cgroups_.Forget(pid);
+    }
+  }
+  cgroups_.Refresh();
+#endif
+}
+
+// The values of disabled collectors are left as they are, i.e. empty
+void System::Capture(Sample& sample, size_t top) {
+  sample.timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
+                         std::chrono::system_clock::now().time_since_epoch())
+                         .count();
+  sample.uptime = UpTime();
+  for (const CaptureStep step : captureSteps_) {
+    (this->*step)(sample, top);
+  }
+}
+
+void System::CaptureCpu(Sample& sample, size_t) {
+  sample.cpu = cpu_.Utilization();
+  sample.steal = cpu_.Steal();
+  sample.totalProcesses = TotalProcesses();
+  sample.runningProcesses = RunningProcesses();
+  sample.contextSwitches = stat_.contextSwitches;
+  sample.interrupts = stat_.interrupts;
+  sample.cores = cpu_.CoreUtilization();
+}
+
+void System::CaptureMemory(Sample& sample, size_t) {
+  sample.memory = MemoryUtilization();
+}
+
+void System::CaptureProcesses(Sample& sample, size_t top) {
+  // Assign element-wise so the strings of the previous sample are reused
+  const vector<ProcessTable::Row>& processes = TopProcesses(top);
+  for (size_t i = 0; i < processes.size(); ++i) {
+    const ProcessTable::Row& process = processes[i];
+    if (i < sample.processes.size()) {
+      sample.processes[i].Assign(
+          process.Pid(), process.User(), process.Command(),
+          process.CpuUtilization(), process.RamMb(), process.UpTime(),
+          process.ReadRate(), process.WriteRate());
+    } else {
+      sample.processes.emplace_back(
+          process.Pid(), std::string(process.User()),
+          std::string(process.Command()), process.CpuUtilization(),
+          process.RamMb(), process.UpTime(), process.ReadRate(),
+          process.WriteRate());
+    }
+  }
+  sample.processes.erase(sample.processes.begin() + processes.size(),
+                         sample.processes.end());
+}
+
+#if MONITOR_COLLECT_CGROUPS
+// Copy the top cgroups in the sort order into sample. Age has no meaning for
+// a cgroup, it orders by the number of processes instead.
+void System::CaptureCgroups(Sample& sample, size_t top) {
+  sample.cgroupView = showCgroups_;
+  const vector<CgroupTable::Cgroup>& cgroups = cgroups_.Cgroups();
+  cgroupKeys_.resize(cgroups.size());
+  for (size_t i = 0; i < cgroups.size(); ++i) {
+    double value = 0;
+    switch (sortColumn_) {
+      case SortColumn::kCpu:
+        value = cgroups[i].cpu;
+        break;
+      case SortColumn::kRam:
+        value = cgroups[i].counters.memoryBytes;
+        break;
+      case SortColumn::kTime:
+        value = cgroups[i].processes;
+        break;
+      case SortColumn::kIo:
+        value = cgroups[i].readRate + cgroups[i].writeRate;
+        break;
+    }
+    cgroupKeys_[i] = {value, static_cast<std::uint32_t>(i)};
+  }
+  top = std::min(top, cgroupKeys_.size());
+  std::partial_sort(cgroupKeys_.begin(), cgroupKeys_.begin() + top,
+                    cgroupKeys_.end(), std::greater<>());
+  sample.cgroups.resize(top);
+  for (size_t i = 0; i < top; ++i) {
+    const CgroupTable::Cgroup& cgroup = cgroups[cgroupKeys_[i].second];
+    CgroupSample& out = sample.cgroups[i];
+    out.path = cgroup.path;
+    out.processes = cgroup.processes;
+    out.cpu = cgroup.cpu;
+    out.memoryMb = cgroup.counters.memoryBytes >> 20;
+    out.readRate = cgroup.readRate;
+    out.writeRate = cgroup.writeRate;
+  }
+}
+#endif
+
+#if MONITOR_COLLECT_DEVICES
+// Copy the top busiest disks and interfaces into sample, whatever the sort
+// column
+void System::CaptureDevices(Sample& sample, size_t top) {
+  const vector<DeviceTable::Disk>& disks = devices_.Disks();
+  deviceKeys_.resize(disks.size());
+  for (size_t i = 0; i < disks.size(); ++i) {
+    deviceKeys_[i] = {disks[i].readRate + disks[i].writeRate,
+                      static_cast<std::uint32_t>(i)};
+  }
+  size_t count = std::min(top, deviceKeys_.size());
+  std::partial_sort(deviceKeys_.begin(), deviceKeys_.begin() + count,
+                    deviceKeys_.end(), std::greater<>());
+  sample.disks.resize(count);
+  for (size_t i = 0; i < count; ++i) {
+    const DeviceTable::Disk& disk = disks[deviceKeys_[i].second];
+    DiskSample& out = sample.disks[i];
+    out.name = disk.name;
+    out.readRate = disk.readRate;
+    out.writeRate = disk.writeRate;
+    out.iops = disk.iops;
+    out.utilization = disk.utilization;
+  }
+
+  const vector<DeviceTable::Interface>& interfaces = devices_.Interfaces();
+  deviceKeys_.resize(interfaces.size());
+  for (size_t i = 0; i < interfaces.size(); ++i) {
+    deviceKeys_[i] = {interfaces[i].receiveRate + interfaces[i].transmitRate,
+                      static_cast<std::uint32_t>(i)};
+  }
+  count = std::min(top, deviceKeys_.size());
+  std::partial_sort(deviceKeys_.begin(), deviceKeys_.begin() + count,
+                    deviceKeys_.end(), std::greater<>());
+  sample.interfaces.resize(count);
+  for (size_t i = 0; i < count; ++i) {
+    const DeviceTable::Interface& interface =
+        interfaces[deviceKeys_[i].second];
+    InterfaceSample& out = sample.interfaces[i];
+    out.name = interface.name;
+    out.receiveRate = interface.receiveRate;
+    out.transmitRate = interface.transmitRate;
+  }
+}
+#endif
+
+#if MONITOR_COLLECT_THREADS
+// Copy the top busiest threads, of the expanded process unless the hot view
+// is on, into sample
+void System::CaptureThreads(Sample& sample, size_t top) {
+  const ThreadSelection& selection = threadSelection_;
+  sample.expanded = selection.expanded;
+  sample.hotThreads = selection.hot;
+  const vector<ThreadTable::Thread>& threads = threads_.Threads();
+  threadKeys_.clear();
+  for (size_t i = 0; i < threads.size(); ++i) {
+    if (selection.hot || threads[i].pid == selection.expanded) {
+      threadKeys_.emplace_back(threads[i].cpu, static_cast<std::uint32_t>(i));
+    }
+  }
+  top = std::min(top, threadKeys_.size());
+  std::partial_sort(threadKeys_.begin(), threadKeys_.begin() + top,
+                    threadKeys_.end(), std::greater<>());
+  sample.threads.resize(top);
+  for (size_t i = 0; i < top; ++i) {
+    const ThreadTable::Thread& thread = threads[threadKeys_[i].second];
+    ThreadSample& out = sample.threads[i];
+    out.tid = thread.tid;
+    out.pid = thread.pid;
+    out.cpu = thread.cpu;
+    out.name = thread.name;
+    const size_t owner = table_.Find(thread.pid);
+    if (owner < table_.Size()) {
+      out.command = table_[owner].Command();
+    } else {
+      out.command.clear();
+    }
+  }
+}
+#endif
+
+void System::Load(const Sample& sample) {
+  cpu_.Assign(sample.cpu, sample.steal, sample.cores);
+  stat_.processes = sample.totalProcesses;
+  stat_.procsRunning = sample.runningProcesses;
+  stat_.contextSwitches = sample.contextSwitches;
+  stat_.interrupts = sample.interrupts;
+  table_.Assign(sample.processes);
+}
+
+const ProcessTable& System::Table() const { return table_; }
+
+// Build the compact (value, row) array the orderings work on, from one
+// column of the table
+void System::FillKeys() {
+  keys_.resize(table_.Size());
+  auto fill = [this](const auto& column) {
+    for (size_t row = 0; row < column.size(); ++row) {
+      keys_[row] = {double(column[row]), static_cast<std::uint32_t>(row)};
+    }
+  };
+  switch (sortColumn_) {
+    case SortColumn::kCpu:
+      fill(table_.Cpu());
+      break;
+    case SortColumn::kRam:
+      fill(table_.RamMb());
+      break;
+    case SortColumn::kTime:
+      fill(table_.UpTime());
+      break;
+    case SortColumn::kIo: {
+      const vector<float>& read = table_.ReadRate();
+      const vector<float>& write = table_.WriteRate();
+      for (size_t row = 0; row < read.size(); ++row) {
+        keys_[row] = {double(read[row]) + write[row],
+                      static_cast<std::uint32_t>(row)};
+      }
+      break;
+    }
   }
-  sort(processes_.rbegin(), processes_.rend());
-  return processes_;
 }
 
 // Return the system's kernel identifier
-string System::Kernel() { return LinuxParser::Kernel(); }
+const string& System::Kernel() {
+  if (kernel_.empty()) {
+    kernel_ = LinuxParser::Kernel();
+  }
+  return kernel_;
+}
 
 // Return the system's memory utilization
 float System::MemoryUtilization() { return LinuxParser::MemoryUtilization(); }
 
 // Return the operating system name
-string System::OperatingSystem() { return LinuxParser::OperatingSystem(); }
+const string& System::OperatingSystem() {
+  if (operatingSystem_.empty()) {
+    operatingSystem_ = LinuxParser::OperatingSystem();
+  }
+  return operatingSystem_;
+}
 
 // Return the number of processes actively running on the system
-int System::RunningProcesses() { return LinuxParser::RunningProcesses(); }
+int System::RunningProcesses() { return stat_.procsRunning; }
 
 // Return the total number of processes on the system
-int System::TotalProcesses() { return LinuxParser::TotalProcesses(); }
+int System::TotalProcesses() { return stat_.processes; }
 
 // Return the number of seconds since the system started running
 long int System::UpTime() { return LinuxParser::UpTime(); }
\ No newline at end of file
@@ -0,0 +1,96 @@
+#include "thread_table.h"
+
+#include <unistd.h>
+
+#include <charconv>
+#include <tuple>
+
+#include "profiler.h"
+
+void ThreadTable::Refresh(WorkerPool& pool, const std::vector<int>& pids,
+                          long uptime) {
+  const auto now = std::chrono::steady_clock::now();
+  const double elapsed =
+      lastRefresh_ == std::chrono::steady_clock::time_point{}
+          ? 0
+          : std::chrono::duration<double>(now - lastRefresh_).count();
+  lastRefresh_ = now;
+
+  if (workers_ != pool.Size()) {
+    workers_ = pool.Size();
+    readers_ = std::make_unique<Reader[]>(workers_);
+  }
+  if (slots_.size() < pids.size()) {
+    slots_.resize(pids.size());
+  }
+  PROFILE_SCOPE(kThreads);
+  pool.ParallelFor(pids.size(), [&](std::size_t i, std::size_t worker) {
+    Reader& reader = readers_[worker];
+    Slot& slot = slots_[i];
+    slot.count = 0;
+    char pid[16];
+    reader.path = LinuxParser::ProcDirectory();
+    reader.path.append(pid, std::to_chars(pid, pid + sizeof(pid), pids[i]).ptr);
+    reader.path += LinuxParser::kTaskDirectory;
+    if (!reader.scanner.Scan(reader.path)) {
+      return;
+    }
+    for (const int tid : reader.scanner.Pids()) {
+      if (slot.count == slot.tasks.size()) {
+        slot.tasks.emplace_back();
+      }
+      if (LinuxParser::ReadTask(pids[i], tid, slot.tasks[slot.count])) {
+        ++slot.count;
+      }
+    }
+  });
+
+  std::size_t total = 0;
+  for (std::size_t i = 0; i < pids.size(); ++i) {
+    total += slots_[i].count;
+  }
+  next_.resize(total);
+  const long ticks = sysconf(_SC_CLK_TCK);
+  std::size_t previous = 0;
+  std::size_t k = 0;
+  for (std::size_t i = 0; i < pids.size(); ++i) {
+    const Slot& slot = slots_[i];
+    for (std::size_t j = 0; j < slot.count; ++j) {
+      const LinuxParser::TaskSnapshot& task = slot.tasks[j];
+      const int tid = task.stat.pid;
+      while (previous < threads_.size() &&
+             std::tie(threads_[previous].pid, threads_[previous].tid) <
+                 std::tie(pids[i], tid)) {
+        ++previous;
+      }
+      const unsigned long jiffies = task.stat.utime + task.stat.stime;
+      Thread& thread = next_[k++];
+      if (elapsed > 0 && previous < threads_.size() &&
+          threads_[previous].pid == pids[i] && threads_[previous].tid == tid &&
+          threads_[previous].starttime == task.stat.starttime &&
+          jiffies >= threads_[previous].activeJiffies) {
+        thread.cpu =
+            double(jiffies - threads_[previous].activeJiffies) / ticks /
+            elapsed;
+      } else {
+        const long lifetime = uptime - task.stat.starttime / ticks;
+        thread.cpu = lifetime > 0 ? double(jiffies) / ticks / lifetime : 0;
+      }
+      thread.pid = pids[i];
+      thread.tid = tid;
+      thread.starttime = task.stat.starttime;
+      thread.activeJiffies = jiffies;
+      thread.name = task.name;
+    }
+  }
+  threads_.swap(next_);
+}
+
+void ThreadTable::Clear() {
+  threads_.clear();
+  lastRefresh_ = {};
+}
+
+const std::vector<ThreadTable::Thread>& ThreadTable::Threads() const {
+  return threads_;
+}
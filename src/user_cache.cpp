@@ -0,0 +1,84 @@
+#include "user_cache.h"
+
+#include <pwd.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+// Reload the passwd file if it is a different file or was modified
+void UserCache::Refresh(const std::string& path) {
+  struct stat info {};
+  if (stat(path.c_str(), &info) != 0) {
+    info = {};
+    info.st_size = -1;
+  }
+  if (path == path_ && info.st_dev == device_ && info.st_ino == inode_ &&
+      info.st_size == size_ && info.st_mtim.tv_sec == mtime_.tv_sec &&
+      info.st_mtim.tv_nsec == mtime_.tv_nsec) {
+    return;
+  }
+  path_ = path;
+  device_ = info.st_dev;
+  inode_ = info.st_ino;
+  size_ = info.st_size;
+  mtime_ = info.st_mtim;
+  Load();
+}
+
+// Return the name of uid, or the uid itself if it cannot be resolved
+const std::string& UserCache::Name(int uid) {
+  auto found = names_.find(uid);
+  if (found != names_.end()) {
+    return found->second;
+  }
+
+  std::string name;
+  passwd entry{};
+  passwd* result = nullptr;
+  long size = sysconf(_SC_GETPW_R_SIZE_MAX);
+  std::vector<char> buffer(size > 0 ? size : 16384);
+  if (uid >= 0 && getpwuid_r(uid, &entry, buffer.data(), buffer.size(),
+                             &result) == 0 &&
+      result != nullptr) {
+    name = result->pw_name;
+  } else if (uid >= 0) {
+    name = std::to_string(uid);
+  }
+  return names_.emplace(uid, std::move(name)).first->second;
+}
+
+// Parse name:password:uid:... lines into the map
+void UserCache::Load() {
+  names_.clear();
+  std::ifstream stream(path_, std::ios::binary);
+  const std::string content{std::istreambuf_iterator<char>(stream),
+                            std::istreambuf_iterator<char>()};
+
+  const char* cursor = content.data();
+  const char* const end = cursor + content.size();
+  while (cursor < end) {
+    const char* eol =
+        static_cast<const char*>(std::memchr(cursor, '\n', end - cursor));
+    if (eol == nullptr) {
+      eol = end;
+    }
+    const char* nameEnd =
+        static_cast<const char*>(std::memchr(cursor, ':', eol - cursor));
+    const char* password =
+        nameEnd ? static_cast<const char*>(
+                      std::memchr(nameEnd + 1, ':', eol - nameEnd - 1))
+                : nullptr;
+    int uid{-1};
+    if (password != nullptr &&
+        std::from_chars(password + 1, eol, uid).ec == std::errc()) {
+      // The first entry wins, like getpwuid() does.
+      names_.emplace(uid, std::string(cursor, nameEnd));
+    }
+    cursor = eol + 1;
+  }
+}
@@ -0,0 +1,132 @@
+#include "worker_pool.h"
+
+#include <algorithm>
+
+namespace {
+std::uint64_t Pack(std::uint32_t begin, std::uint32_t end) {
+  return begin | (std::uint64_t(end) << 32);
+}
+std::uint32_t Begin(std::uint64_t bounds) { return bounds & 0xffffffffu; }
+std::uint32_t End(std::uint64_t bounds) { return bounds >> 32; }
+}  // namespace
+
+WorkerPool::WorkerPool(std::size_t threads)
+    : size_(threads ? threads
+                    : std::max(1u, std::thread::hardware_concurrency())) {
+  ranges_ = std::make_unique<Range[]>(size_);
+  for (std::size_t worker = 1; worker < size_; ++worker) {
+    threads_.emplace_back(&WorkerPool::Loop, this, worker);
+  }
+}
+
+WorkerPool::~WorkerPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  start_.notify_all();
+  for (auto& thread : threads_) {
+    thread.join();
+  }
+}
+
+// Return the number of workers including the calling thread
+std::size_t WorkerPool::Size() const { return size_; }
+
+void WorkerPool::ParallelFor(std::size_t count, const Task& task) {
+  if (size_ == 1 || count < 2) {
+    for (std::size_t index = 0; index < count; ++index) {
+      task(index, 0);
+    }
+    return;
+  }
+
+  for (std::size_t worker = 0; worker < size_; ++worker) {
+    ranges_[worker].bounds.store(Pack(count * worker / size_,
+                                      count * (worker + 1) / size_),
+                                 std::memory_order_relaxed);
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    task_ = &task;
+    running_ = size_ - 1;
+    ++generation_;
+  }
+  start_.notify_all();
+
+  Work(0);
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  done_.wait(lock, [this] { return running_ == 0; });
+  task_ = nullptr;
+}
+
+// Body of the pool threads: run every ParallelFor() once
+void WorkerPool::Loop(std::size_t worker) {
+  std::uint64_t generation = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      start_.wait(lock,
+                  [&] { return stop_ || generation_ != generation; });
+      if (stop_) {
+        return;
+      }
+      generation = generation_;
+    }
+    Work(worker);
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (--running_ == 0) {
+        done_.notify_one();
+      }
+    }
+  }
+}
+
+void WorkerPool::Work(std::size_t worker) {
+  std::size_t index;
+  while (Next(worker, index)) {
+    (*task_)(index, worker);
+  }
+}
+
+// Take the next index from the own range, stealing when it is empty
+bool WorkerPool::Next(std::size_t worker, std::size_t& index) {
+  auto& bounds = ranges_[worker].bounds;
+  while (true) {
+    std::uint64_t current = bounds.load(std::memory_order_acquire);
+    while (Begin(current) < End(current)) {
+      if (bounds.compare_exchange_weak(
+              current, Pack(Begin(current) + 1, End(current)),
+              std::memory_order_acq_rel)) {
+        index = Begin(current);
+        return true;
+      }
+    }
+    if (!Steal(worker)) {
+      return false;
+    }
+  }
+}
+
+// Move the back half of another worker's range into the own (empty) range.
+// Returns false once every range is empty.
+bool WorkerPool::Steal(std::size_t worker) {
+  for (std::size_t offset = 1; offset < size_; ++offset) {
+    auto& bounds = ranges_[(worker + offset) % size_].bounds;
+    std::uint64_t current = bounds.load(std::memory_order_acquire);
+    while (Begin(current) < End(current)) {
+      const std::uint32_t middle =
+          Begin(current) + (End(current) - Begin(current)) / 2;
+      if (bounds.compare_exchange_weak(current,
+                                       Pack(Begin(current), middle),
+                                       std::memory_order_acq_rel)) {
+        ranges_[worker].bounds.store(Pack(middle, End(current)),
+                                     std::memory_order_release);
+        return true;
+      }
+    }
+  }
+  return false;
+}